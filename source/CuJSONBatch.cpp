@@ -0,0 +1,199 @@
+#include "CuJSONBatch.h"
+#include "CuJSONParallel.h"
+
+namespace CU
+{
+	namespace
+	{
+		// Documents claimed at once by a thread: small enough to balance uneven documents,
+		// big enough to keep the threads off the shared counter.
+		constexpr size_t _ChunkDocuments = 64;
+
+		// Keeps the blocks the arena gives back on release() and hands them out again, so
+		// batches after the first do not touch the heap or fault in new pages.
+		class _BlockCache : public std::pmr::memory_resource
+		{
+			public:
+				_BlockCache(std::pmr::memory_resource* upstream) : upstream_(upstream), blocks_() { }
+
+				~_BlockCache()
+				{
+					for (const auto &block : blocks_) {
+						upstream_->deallocate(block.data, block.bytes, block.alignment);
+					}
+				}
+
+			private:
+				struct _Block
+				{
+					void* data;
+					size_t bytes;
+					size_t alignment;
+				};
+
+				std::pmr::memory_resource* upstream_;
+				std::vector<_Block> blocks_;
+
+				void* do_allocate(size_t bytes, size_t alignment) override
+				{
+					for (auto iter = blocks_.begin(); iter != blocks_.end(); iter++) {
+						if (iter->bytes == bytes && iter->alignment == alignment) {
+							const auto data = iter->data;
+							blocks_.erase(iter);
+							return data;
+						}
+					}
+					return upstream_->allocate(bytes, alignment);
+				}
+
+				void do_deallocate(void* data, size_t bytes, size_t alignment) override
+				{
+					blocks_.emplace_back(_Block{data, bytes, alignment});
+				}
+
+				bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+				{
+					return (this == std::addressof(other));
+				}
+		};
+	}
+
+	// The arena hands out memory by bumping a pointer and frees nothing until release(),
+	// which gives its blocks back to the cache for the next batch.
+	struct JSONBatch::_Worker
+	{
+		_BlockCache blocks;
+		std::pmr::monotonic_buffer_resource arena;
+		JSONParser parser;
+		size_t failures;
+
+		_Worker(std::pmr::memory_resource* upstream) : blocks(upstream), arena(std::addressof(blocks)), parser(), failures(0) { }
+	};
+}
+
+CU::JSONBatchOptions::JSONBatchOptions() : threads(1), minThreadDocuments(512), parserOptions() { }
+
+CU::JSONBatch::JSONBatch() : JSONBatch(std::pmr::get_default_resource()) { }
+
+CU::JSONBatch::JSONBatch(std::pmr::memory_resource* upstream) : 
+	upstream_(upstream),
+	workers_(),
+	slots_(),
+	errors_(),
+	touched_(),
+	size_(0),
+	failures_(0)
+{ }
+
+CU::JSONBatch::~JSONBatch()
+{
+	clear();
+}
+
+void CU::JSONBatch::parse(const std::string_view* texts, const size_t &count, const JSONBatchOptions &options)
+{
+	clear();
+	const auto workers = _WorkerCount(count, options.threads, options.minThreadDocuments);
+	while (workers_.size() < workers) {
+		workers_.emplace_back(std::make_unique<_Worker>(upstream_));
+	}
+	if (slots_.size() < count) {
+		slots_.resize(count);
+	}
+	errors_.resize(count);
+	touched_.assign(count, 0);
+	for (size_t worker = 0; worker < workers; worker++) {
+		workers_[worker]->parser.setOptions(options.parserOptions);
+		workers_[worker]->failures = 0;
+	}
+	// Failures, allocation failures included, stay with their document, so every slot
+	// below count holds an object afterwards and clear() may destroy them all.
+	const auto run = [this, texts, count](const size_t &chunk, const size_t &worker) {
+		auto &state = *workers_[worker];
+		JSONMemoryScope scope(std::addressof(state.arena));
+		const auto end = std::min(count, (chunk + 1) * _ChunkDocuments);
+		for (auto pos = chunk * _ChunkDocuments; pos < end; pos++) {
+			auto &object = *new (slots_[pos].storage) JSONObject();
+			try {
+				state.parser.parse(texts[pos], object);
+			} catch (const std::exception &e) {
+				object.clear();
+				errors_[pos] = e.what();
+				state.failures++;
+			}
+		}
+	};
+	const auto chunks = (count + _ChunkDocuments - 1) / _ChunkDocuments;
+	size_ = count;
+	if (workers == 1) {
+		for (size_t chunk = 0; chunk < chunks; chunk++) {
+			run(chunk, 0);
+		}
+	} else {
+		_ParallelFor(chunks, workers, run);
+	}
+	for (size_t worker = 0; worker < workers; worker++) {
+		failures_ += workers_[worker]->failures;
+	}
+}
+
+void CU::JSONBatch::parse(const std::vector<std::string_view> &texts, const JSONBatchOptions &options)
+{
+	parse(texts.data(), texts.size(), options);
+}
+
+size_t CU::JSONBatch::size() const noexcept
+{
+	return size_;
+}
+
+size_t CU::JSONBatch::failures() const noexcept
+{
+	return failures_;
+}
+
+bool CU::JSONBatch::ok(const size_t &pos) const
+{
+	return error(pos).empty();
+}
+
+const std::string &CU::JSONBatch::error(const size_t &pos) const
+{
+	if (pos >= size_) {
+		throw JSONExcept("Position out of bound");
+	}
+	return errors_[pos];
+}
+
+CU::JSONObject &CU::JSONBatch::operator[](const size_t &pos)
+{
+	if (pos >= size_) {
+		throw JSONExcept("Position out of bound");
+	}
+	touched_[pos] = 1;
+	return *std::launder(reinterpret_cast<JSONObject*>(slots_[pos].storage));
+}
+
+const CU::JSONObject &CU::JSONBatch::operator[](const size_t &pos) const
+{
+	if (pos >= size_) {
+		throw JSONExcept("Position out of bound");
+	}
+	return *std::launder(reinterpret_cast<const JSONObject*>(slots_[pos].storage));
+}
+
+void CU::JSONBatch::clear()
+{
+	// A document edited through operator[] may hold memory from outside its arena.
+	for (size_t pos = 0; pos < size_; pos++) {
+		if (touched_[pos] != 0) {
+			std::launder(reinterpret_cast<JSONObject*>(slots_[pos].storage))->~JSONObject();
+		}
+		errors_[pos].clear();
+	}
+	size_ = 0;
+	failures_ = 0;
+	for (auto &worker : workers_) {
+		worker->arena.release();
+	}
+}
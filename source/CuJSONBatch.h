@@ -0,0 +1,67 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONBATCH_
+#define _CU_JSONBATCH_
+
+#include "CuJSONParser.h"
+#include <memory>
+
+namespace CU
+{
+	struct JSONBatchOptions
+	{
+		size_t threads;
+		size_t minThreadDocuments;
+		JSONParser::Options parserOptions;
+
+		JSONBatchOptions();
+	};
+
+	// Parses many small JSONObject documents at once. Every thread keeps one parser and one
+	// arena for the whole batch, so a document costs no parser setup and no heap allocation
+	// once the arenas have grown. Batches with fewer than minThreadDocuments documents per
+	// thread stay on the calling thread; threads == 0 allows every hardware thread.
+	// A document that fails to parse is left empty and keeps the message of its JSONExcept.
+	// The objects live in the arenas and are destroyed by the next parse() or clear(); the
+	// ones never handed out by the non-const operator[] hold nothing but arena memory and
+	// are dropped with their arena without walking them.
+	class JSONBatch
+	{
+		public:
+			JSONBatch();
+			JSONBatch(std::pmr::memory_resource* upstream);
+			~JSONBatch();
+
+			JSONBatch(const JSONBatch &) = delete;
+			JSONBatch &operator=(const JSONBatch &) = delete;
+
+			void parse(const std::string_view* texts, const size_t &count, const JSONBatchOptions &options = JSONBatchOptions());
+			void parse(const std::vector<std::string_view> &texts, const JSONBatchOptions &options = JSONBatchOptions());
+
+			size_t size() const noexcept;
+			size_t failures() const noexcept;
+			bool ok(const size_t &pos) const;
+			const std::string &error(const size_t &pos) const;
+			JSONObject &operator[](const size_t &pos);
+			const JSONObject &operator[](const size_t &pos) const;
+			void clear();
+
+		private:
+			struct _Worker;
+			struct _Slot
+			{
+				alignas(JSONObject) unsigned char storage[sizeof(JSONObject)];
+			};
+
+			std::pmr::memory_resource* upstream_;
+			std::vector<std::unique_ptr<_Worker>> workers_;
+			std::vector<_Slot> slots_;
+			std::vector<std::string> errors_;
+			std::vector<uint8_t> touched_;
+			size_t size_;
+			size_t failures_;
+	};
+}
+
+#endif // _CU_JSONBATCH_
@@ -0,0 +1,630 @@
+#include "CuJSONCBOR.h"
+#include "CuJSONParser.h"
+#include "CuJSONStats.h"
+#include <cstring>
+#include <cmath>
+
+namespace CU
+{
+	namespace
+	{
+		constexpr uint8_t _MajorUnsigned = 0;
+		constexpr uint8_t _MajorNegative = 1;
+		constexpr uint8_t _MajorBytes = 2;
+		constexpr uint8_t _MajorText = 3;
+		constexpr uint8_t _MajorArray = 4;
+		constexpr uint8_t _MajorMap = 5;
+		constexpr uint8_t _MajorTag = 6;
+		constexpr uint8_t _MajorSimple = 7;
+		constexpr uint8_t _InfoIndefinite = 31;
+		constexpr uint8_t _CBORBreak = 0xFF;
+		constexpr uint64_t _TagInt32Array = 78;
+		constexpr uint64_t _TagInt64Array = 79;
+		constexpr uint64_t _TagDoubleArray = 86;
+
+		class _CBORWriter
+		{
+			public:
+				_CBORWriter(std::string &buffer) : buffer_(buffer) { }
+
+				void write(const JSONItem &item)
+				{
+					switch (item.type()) {
+						case ItemType::ITEM_NULL:
+							buffer_ += static_cast<char>(0xF6);
+							break;
+						case ItemType::BOOLEAN:
+							buffer_ += static_cast<char>(item.toBoolean() ? 0xF5 : 0xF4);
+							break;
+						case ItemType::INTEGER:
+							_WriteInteger(item.toInt(), false);
+							break;
+						case ItemType::LONG:
+							_WriteInteger(item.toLong(), true);
+							break;
+						case ItemType::DOUBLE:
+							{
+								uint64_t bits = 0;
+								const double value = item.toDouble();
+								std::memcpy(&bits, &value, sizeof(bits));
+								buffer_ += static_cast<char>(0xFB);
+								_WriteBigEndian(bits, 8);
+							}
+							break;
+						case ItemType::STRING:
+							_WriteText(item.asString());
+							break;
+						case ItemType::ARRAY:
+							write(item.asArray());
+							break;
+						case ItemType::OBJECT:
+							write(item.asObject());
+							break;
+					}
+				}
+
+				void write(const JSONArray &array)
+				{
+					if (_WriteTypedArray(array)) {
+						return;
+					}
+					_WriteHead(_MajorArray, array.size());
+					for (const auto &item : array) {
+						write(item);
+					}
+				}
+
+				void write(const JSONObject &object)
+				{
+					_WriteHead(_MajorMap, object.size());
+					for (const auto &[key, value] : object) {
+						_WriteText(key);
+						write(value);
+					}
+				}
+
+			private:
+				std::string &buffer_;
+
+				void _WriteBigEndian(const uint64_t &value, const size_t &width)
+				{
+					for (size_t shift = width * 8; shift > 0; shift -= 8) {
+						buffer_ += static_cast<char>((value >> (shift - 8)) & 0xFF);
+					}
+				}
+
+				void _WriteLittleEndian(const uint64_t &value, const size_t &width)
+				{
+					for (size_t shift = 0; shift < width * 8; shift += 8) {
+						buffer_ += static_cast<char>((value >> shift) & 0xFF);
+					}
+				}
+
+				void _WriteHead(const uint8_t &major, const uint64_t &value)
+				{
+					const auto type = static_cast<uint8_t>(major << 5);
+					if (value < 24) {
+						buffer_ += static_cast<char>(type | value);
+					} else if (value <= 0xFF) {
+						buffer_ += static_cast<char>(type | 24);
+						_WriteBigEndian(value, 1);
+					} else if (value <= 0xFFFF) {
+						buffer_ += static_cast<char>(type | 25);
+						_WriteBigEndian(value, 2);
+					} else if (value <= 0xFFFFFFFF) {
+						buffer_ += static_cast<char>(type | 26);
+						_WriteBigEndian(value, 4);
+					} else {
+						_WriteWideHead(major, value);
+					}
+				}
+
+				void _WriteWideHead(const uint8_t &major, const uint64_t &value)
+				{
+					buffer_ += static_cast<char>((major << 5) | 27);
+					_WriteBigEndian(value, 8);
+				}
+
+				// The 8-byte head is what tells a LONG apart from an INTEGER.
+				void _WriteInteger(const int64_t &value, const bool &wide)
+				{
+					const auto major = (value < 0) ? _MajorNegative : _MajorUnsigned;
+					const auto argument = (value < 0) ? static_cast<uint64_t>(-(value + 1)) : static_cast<uint64_t>(value);
+					if (wide) {
+						_WriteWideHead(major, argument);
+					} else {
+						_WriteHead(major, argument);
+					}
+				}
+
+				void _WriteText(const std::string_view &text)
+				{
+					_WriteHead(_MajorText, text.size());
+					buffer_.append(text.data(), text.size());
+				}
+
+				bool _WriteTypedArray(const JSONArray &array)
+				{
+					if (array.size() < 2) {
+						return false;
+					}
+					const auto type = array.begin()->type();
+					if (type != ItemType::INTEGER && type != ItemType::LONG && type != ItemType::DOUBLE) {
+						return false;
+					}
+					for (const auto &item : array) {
+						if (item.type() != type) {
+							return false;
+						}
+					}
+					if (type == ItemType::INTEGER) {
+						_WriteHead(_MajorTag, _TagInt32Array);
+						_WriteHead(_MajorBytes, array.size() * 4);
+						for (const auto &item : array) {
+							_WriteLittleEndian(static_cast<uint32_t>(item.toInt()), 4);
+						}
+					} else if (type == ItemType::LONG) {
+						_WriteHead(_MajorTag, _TagInt64Array);
+						_WriteHead(_MajorBytes, array.size() * 8);
+						for (const auto &item : array) {
+							_WriteLittleEndian(static_cast<uint64_t>(item.toLong()), 8);
+						}
+					} else {
+						_WriteHead(_MajorTag, _TagDoubleArray);
+						_WriteHead(_MajorBytes, array.size() * 8);
+						for (const auto &item : array) {
+							uint64_t bits = 0;
+							const double value = item.toDouble();
+							std::memcpy(&bits, &value, sizeof(bits));
+							_WriteLittleEndian(bits, 8);
+						}
+					}
+					return true;
+				}
+		};
+
+		template <typename _Value>
+		void _WriteCBOR(const _Value &value, std::string &buffer)
+		{
+			_CU_STATS_PHASE(SERIALIZE, 0);
+			const auto begin = buffer.size();
+			_CBORWriter(buffer).write(value);
+			_CU_STATS_OUTPUT(buffer.size() - begin);
+			(void)begin;
+		}
+
+		double _HalfToDouble(const uint16_t &half) noexcept
+		{
+			const int exponent = (half >> 10) & 0x1F;
+			const int mantissa = half & 0x3FF;
+			double value = 0.0;
+			if (exponent == 0) {
+				value = std::ldexp(mantissa, -24);
+			} else if (exponent != 31) {
+				value = std::ldexp(mantissa + 1024, exponent - 25);
+			} else {
+				value = (mantissa == 0) ? INFINITY : NAN;
+			}
+			return (half & 0x8000) ? -value : value;
+		}
+	}
+
+	// Fills the nodes directly, like JSONParser, so strings and containers are built once.
+	class _CBORReader
+	{
+		public:
+			_CBORReader(const std::string_view &data) :
+				begin_(reinterpret_cast<const uint8_t*>(data.data())),
+				cur_(begin_),
+				end_(begin_ + data.size()),
+				maxDepth_(JSONParser::Options().maxDepth)
+			{ }
+
+			void read(JSONItem &item, const size_t &depth)
+			{
+				auto head = _Byte();
+				// Other semantic tags have no JSON counterpart and the tagged value is kept. They
+				// are skipped in a loop, so a long run of tags cannot exhaust the stack.
+				while ((head >> 5) == _MajorTag) {
+					const auto tag = _Argument(static_cast<uint8_t>(head & 0x1F));
+					if (tag == _TagInt32Array || tag == _TagInt64Array || tag == _TagDoubleArray) {
+						auto array = _NewContainer<JSONArray>(item, ItemType::ARRAY, depth);
+						_ReadTypedArray(*array, tag);
+						return;
+					}
+					head = _Byte();
+				}
+				const auto major = static_cast<uint8_t>(head >> 5);
+				const auto info = static_cast<uint8_t>(head & 0x1F);
+				switch (major) {
+					case _MajorUnsigned:
+						{
+							const auto value = _Argument(info);
+							if (info == 27) {
+								_SetLong(item, value <= static_cast<uint64_t>(INT64_MAX), static_cast<int64_t>(value), static_cast<double>(value));
+							} else if (value <= static_cast<uint64_t>(INT_MAX)) {
+								item.type_ = ItemType::INTEGER;
+								item.value_ = static_cast<int>(value);
+							} else {
+								item.type_ = ItemType::LONG;
+								item.value_ = static_cast<int64_t>(value);
+							}
+						}
+						break;
+					case _MajorNegative:
+						{
+							const auto value = _Argument(info);
+							if (info == 27) {
+								_SetLong(item, value <= static_cast<uint64_t>(INT64_MAX), -1 - static_cast<int64_t>(value), -1.0 - static_cast<double>(value));
+							} else if (value <= static_cast<uint64_t>(INT_MAX)) {
+								item.type_ = ItemType::INTEGER;
+								item.value_ = static_cast<int>(-1 - static_cast<int64_t>(value));
+							} else {
+								item.type_ = ItemType::LONG;
+								item.value_ = -1 - static_cast<int64_t>(value);
+							}
+						}
+						break;
+					case _MajorBytes:
+						_Throw("Byte strings are not supported");
+						break;
+					case _MajorText:
+						item.type_ = ItemType::STRING;
+						item.value_ = std::pmr::string(GetMemoryResource());
+						_ReadText(std::get<std::pmr::string>(item.value_), info);
+						break;
+					case _MajorArray:
+						{
+							auto array = _NewContainer<JSONArray>(item, ItemType::ARRAY, depth);
+							_ReadArray(*array, info, depth + 1);
+						}
+						break;
+					case _MajorMap:
+						{
+							auto object = _NewContainer<JSONObject>(item, ItemType::OBJECT, depth);
+							_ReadMap(*object, info, depth + 1);
+						}
+						break;
+					case _MajorSimple:
+						_ReadSimple(item, info);
+						break;
+					default:
+						break;
+				}
+			}
+
+			void read(JSONArray &array)
+			{
+				array.clear();
+				const auto head = _Byte();
+				const auto info = static_cast<uint8_t>(head & 0x1F);
+				if ((head >> 5) == _MajorArray) {
+					_ReadArray(array, info, 1);
+					return;
+				}
+				if ((head >> 5) == _MajorTag) {
+					const auto tag = _Argument(info);
+					if (tag == _TagInt32Array || tag == _TagInt64Array || tag == _TagDoubleArray) {
+						_ReadTypedArray(array, tag);
+						return;
+					}
+				}
+				_Throw("Array expected");
+			}
+
+			void read(JSONObject &object)
+			{
+				object.clear();
+				const auto head = _Byte();
+				if ((head >> 5) != _MajorMap) {
+					_Throw("Map expected");
+				}
+				_ReadMap(object, static_cast<uint8_t>(head & 0x1F), 1);
+			}
+
+			void end()
+			{
+				if (cur_ != end_) {
+					_Throw("Unexpected trailing bytes");
+				}
+			}
+
+		private:
+			const uint8_t* begin_;
+			const uint8_t* cur_;
+			const uint8_t* end_;
+			size_t maxDepth_;
+
+			template <typename _Container>
+			_Container* _NewContainer(JSONItem &item, const ItemType &type, const size_t &depth)
+			{
+				if (depth >= maxDepth_) {
+					_Throw("Maximum depth exceeded");
+				}
+				auto container = _NewNode<_Container>();
+				item.type_ = type;
+				item.value_ = container;
+				return container;
+			}
+
+			void _SetLong(JSONItem &item, const bool &fits, const int64_t &value, const double &promoted)
+			{
+				if (fits) {
+					item.type_ = ItemType::LONG;
+					item.value_ = value;
+				} else {
+					item.type_ = ItemType::DOUBLE;
+					item.value_ = promoted;
+				}
+			}
+
+			uint8_t _Byte()
+			{
+				if (cur_ == end_) {
+					_Throw("Unexpected end of input");
+				}
+				return *(cur_++);
+			}
+
+			void _Need(const uint64_t &size)
+			{
+				if (size > static_cast<uint64_t>(end_ - cur_)) {
+					_Throw("Unexpected end of input");
+				}
+			}
+
+			uint64_t _BigEndian(const size_t &width)
+			{
+				_Need(width);
+				uint64_t value = 0;
+				for (size_t pos = 0; pos < width; pos++) {
+					value = (value << 8) | cur_[pos];
+				}
+				cur_ += width;
+				return value;
+			}
+
+			uint64_t _Argument(const uint8_t &info)
+			{
+				if (info < 24) {
+					return info;
+				}
+				switch (info) {
+					case 24:
+						return _BigEndian(1);
+					case 25:
+						return _BigEndian(2);
+					case 26:
+						return _BigEndian(4);
+					case 27:
+						return _BigEndian(8);
+					default:
+						break;
+				}
+				_Throw("Invalid argument");
+				return 0;
+			}
+
+			// A container needs at least one byte per member, which bounds what a
+			// malformed length prefix can make us allocate.
+			size_t _Count(const uint8_t &info, const uint64_t &bytesPerMember)
+			{
+				const auto count = _Argument(info);
+				if (count > static_cast<uint64_t>(end_ - cur_) / bytesPerMember) {
+					_Throw("Invalid length");
+				}
+				return static_cast<size_t>(count);
+			}
+
+			bool _Break()
+			{
+				if (cur_ != end_ && *cur_ == _CBORBreak) {
+					cur_++;
+					return true;
+				}
+				return false;
+			}
+
+			void _ReadText(std::pmr::string &text, const uint8_t &info)
+			{
+				if (info != _InfoIndefinite) {
+					const auto size = _Count(info, 1);
+					text.assign(reinterpret_cast<const char*>(cur_), size);
+					cur_ += size;
+					_CU_STATS_ADD(stringBytes, size);
+					return;
+				}
+				text.clear();
+				while (!_Break()) {
+					const auto head = _Byte();
+					if ((head >> 5) != _MajorText || (head & 0x1F) == _InfoIndefinite) {
+						_Throw("Invalid text chunk");
+					}
+					const auto size = _Count(static_cast<uint8_t>(head & 0x1F), 1);
+					text.append(reinterpret_cast<const char*>(cur_), size);
+					cur_ += size;
+				}
+			}
+
+			void _ReadArray(JSONArray &array, const uint8_t &info, const size_t &depth)
+			{
+				if (info == _InfoIndefinite) {
+					while (!_Break()) {
+						read(array.data_.emplace_back(), depth);
+					}
+					return;
+				}
+				array.data_.resize(_Count(info, 1));
+				for (auto &item : array.data_) {
+					read(item, depth);
+				}
+			}
+
+			void _ReadMap(JSONObject &object, const uint8_t &info, const size_t &depth)
+			{
+				const bool indefinite = (info == _InfoIndefinite);
+				const auto count = indefinite ? 0 : _Count(info, 2);
+				object.data_.reserve(count);
+				object.order_.reserve(count);
+				for (size_t pos = 0; indefinite || pos < count; pos++) {
+					if (indefinite && _Break()) {
+						break;
+					}
+					const auto head = _Byte();
+					if ((head >> 5) != _MajorText) {
+						_Throw("Map keys must be text strings");
+					}
+					std::pmr::string key(GetMemoryResource());
+					_ReadText(key, static_cast<uint8_t>(head & 0x1F));
+					// Duplicated keys keep their first position and the last value, like JSONObject::add().
+					auto result = object.data_.try_emplace(std::move(key));
+					if (result.second) {
+						object.order_.emplace_back(std::addressof(*result.first));
+					} else {
+						result.first->second.clear();
+					}
+					read(result.first->second, depth);
+				}
+			}
+
+			void _ReadTypedArray(JSONArray &array, const uint64_t &tag)
+			{
+				const auto head = _Byte();
+				if ((head >> 5) != _MajorBytes || (head & 0x1F) == _InfoIndefinite) {
+					_Throw("Typed array without byte string");
+				}
+				const size_t width = (tag == _TagInt32Array) ? 4 : 8;
+				const auto size = _Count(static_cast<uint8_t>(head & 0x1F), 1);
+				if (size % width != 0) {
+					_Throw("Invalid typed array length");
+				}
+				array.data_.resize(size / width);
+				for (auto &item : array.data_) {
+					uint64_t value = 0;
+					for (size_t pos = 0; pos < width; pos++) {
+						value |= static_cast<uint64_t>(cur_[pos]) << (pos * 8);
+					}
+					cur_ += width;
+					if (tag == _TagInt32Array) {
+						item.type_ = ItemType::INTEGER;
+						item.value_ = static_cast<int>(static_cast<int32_t>(static_cast<uint32_t>(value)));
+					} else if (tag == _TagInt64Array) {
+						item.type_ = ItemType::LONG;
+						item.value_ = static_cast<int64_t>(value);
+					} else {
+						double number = 0.0;
+						std::memcpy(&number, &value, sizeof(number));
+						item.type_ = ItemType::DOUBLE;
+						item.value_ = number;
+					}
+				}
+			}
+
+			void _ReadSimple(JSONItem &item, const uint8_t &info)
+			{
+				switch (info) {
+					case 20:
+					case 21:
+						item.type_ = ItemType::BOOLEAN;
+						item.value_ = (info == 21);
+						return;
+					case 22:
+					case 23:
+						item.type_ = ItemType::ITEM_NULL;
+						item.value_ = ItemNull();
+						return;
+					case 25:
+						item.type_ = ItemType::DOUBLE;
+						item.value_ = _HalfToDouble(static_cast<uint16_t>(_BigEndian(2)));
+						return;
+					case 26:
+						{
+							const auto bits = static_cast<uint32_t>(_BigEndian(4));
+							float number = 0.0f;
+							std::memcpy(&number, &bits, sizeof(number));
+							item.type_ = ItemType::DOUBLE;
+							item.value_ = static_cast<double>(number);
+						}
+						return;
+					case 27:
+						{
+							const auto bits = _BigEndian(8);
+							double number = 0.0;
+							std::memcpy(&number, &bits, sizeof(number));
+							item.type_ = ItemType::DOUBLE;
+							item.value_ = number;
+						}
+						return;
+					default:
+						break;
+				}
+				_Throw("Unsupported simple value");
+			}
+
+			void _Throw(const char* reason) const
+			{
+				throw JSONExcept(std::string("Invalid CBOR at offset ") + std::to_string(cur_ - begin_) + ": " + reason);
+			}
+	};
+}
+
+void CU::WriteCBOR(const JSONItem &item, std::string &buffer)
+{
+	_WriteCBOR(item, buffer);
+}
+
+void CU::WriteCBOR(const JSONArray &array, std::string &buffer)
+{
+	_WriteCBOR(array, buffer);
+}
+
+void CU::WriteCBOR(const JSONObject &object, std::string &buffer)
+{
+	_WriteCBOR(object, buffer);
+}
+
+std::string CU::ToCBOR(const JSONItem &item)
+{
+	std::string buffer{};
+	_WriteCBOR(item, buffer);
+	return buffer;
+}
+
+std::string CU::ToCBOR(const JSONArray &array)
+{
+	std::string buffer{};
+	_WriteCBOR(array, buffer);
+	return buffer;
+}
+
+std::string CU::ToCBOR(const JSONObject &object)
+{
+	std::string buffer{};
+	_WriteCBOR(object, buffer);
+	return buffer;
+}
+
+void CU::ReadCBOR(const std::string_view &data, JSONItem &item)
+{
+	_CU_STATS_PHASE(PARSE, data.size());
+	item.clear();
+	_CBORReader reader(data);
+	reader.read(item, 0);
+	reader.end();
+}
+
+void CU::ReadCBOR(const std::string_view &data, JSONArray &array)
+{
+	_CU_STATS_PHASE(PARSE, data.size());
+	_CBORReader reader(data);
+	reader.read(array);
+	reader.end();
+}
+
+void CU::ReadCBOR(const std::string_view &data, JSONObject &object)
+{
+	_CU_STATS_PHASE(PARSE, data.size());
+	_CBORReader reader(data);
+	reader.read(object);
+	reader.end();
+}
@@ -0,0 +1,31 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONCBOR_
+#define _CU_JSONCBOR_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	// RFC 8949 CBOR. The ItemType survives a round trip: INTEGER uses the shortest
+	// integer head, LONG always the 8-byte head and DOUBLE always a float64, and the
+	// reader maps them back the same way (wider values promote like the text parser).
+	// Arrays of two or more INTEGER, LONG or DOUBLE items are written as RFC 8746
+	// little endian typed arrays (tags 78, 79 and 86).
+	void WriteCBOR(const JSONItem &item, std::string &buffer);
+	void WriteCBOR(const JSONArray &array, std::string &buffer);
+	void WriteCBOR(const JSONObject &object, std::string &buffer);
+
+	std::string ToCBOR(const JSONItem &item);
+	std::string ToCBOR(const JSONArray &array);
+	std::string ToCBOR(const JSONObject &object);
+
+	// Containers are sized from their length prefix before reading the members.
+	// Byte strings and nesting deeper than JSONParser's default limit throw JSONExcept.
+	void ReadCBOR(const std::string_view &data, JSONItem &item);
+	void ReadCBOR(const std::string_view &data, JSONArray &array);
+	void ReadCBOR(const std::string_view &data, JSONObject &object);
+}
+
+#endif // _CU_JSONCBOR_
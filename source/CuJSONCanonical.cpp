@@ -0,0 +1,270 @@
+#include "CuJSONCanonical.h"
+#include "CuJSONStats.h"
+#include <charconv>
+#include <cmath>
+
+namespace CU
+{
+	namespace
+	{
+		// Sorted member index of the objects being written, one slice per nesting level.
+		thread_local std::vector<const JSONObject::Entry*> threadKeys{};
+
+		// UTF-8 byte order equals code point order. UTF-16 only differs for supplementary
+		// code points, whose surrogates sort below U+E000..U+FFFF, so just that case is fixed up.
+		bool _KeyLess(const JSONObject::Entry* entry, const JSONObject::Entry* otherEntry) noexcept
+		{
+			const auto &key = entry->first;
+			const auto &other = otherEntry->first;
+			const auto size = std::min(key.size(), other.size());
+			size_t pos = 0;
+			while (pos < size && key[pos] == other[pos]) {
+				pos++;
+			}
+			if (pos == size) {
+				return (key.size() < other.size());
+			}
+			const auto byte = static_cast<uint8_t>(key[pos]);
+			const auto otherByte = static_cast<uint8_t>(other[pos]);
+			if (byte >= 0xF0 && (otherByte == 0xEE || otherByte == 0xEF)) {
+				return true;
+			}
+			if ((byte == 0xEE || byte == 0xEF) && otherByte >= 0xF0) {
+				return false;
+			}
+			return (byte < otherByte);
+		}
+
+		class _CanonicalWriter
+		{
+			public:
+				_CanonicalWriter(std::string &buffer) : buffer_(buffer), keys_(threadKeys)
+				{
+					keys_.clear();
+				}
+
+				void write(const JSONItem &item)
+				{
+					switch (item.type()) {
+						case ItemType::ITEM_NULL:
+							buffer_ += "null";
+							break;
+						case ItemType::BOOLEAN:
+							buffer_ += item.toBoolean() ? "true" : "false";
+							break;
+						case ItemType::INTEGER:
+							_WriteInteger(item.toInt());
+							break;
+						case ItemType::LONG:
+							_WriteInteger(item.toLong());
+							break;
+						case ItemType::DOUBLE:
+							_WriteDouble(item.toDouble());
+							break;
+						case ItemType::STRING:
+							_WriteString(item.asString());
+							break;
+						case ItemType::ARRAY:
+							write(item.asArray());
+							break;
+						case ItemType::OBJECT:
+							write(item.asObject());
+							break;
+					}
+				}
+
+				void write(const JSONArray &array)
+				{
+					buffer_ += '[';
+					for (auto iter = array.begin(); iter != array.end(); iter++) {
+						if (iter != array.begin()) {
+							buffer_ += ',';
+						}
+						write(*iter);
+					}
+					buffer_ += ']';
+				}
+
+				void write(const JSONObject &object)
+				{
+					buffer_ += '{';
+					const auto first = keys_.size();
+					for (const auto &entry : object) {
+						keys_.emplace_back(std::addressof(entry));
+					}
+					const auto last = keys_.size();
+					std::sort(keys_.begin() + first, keys_.end(), _KeyLess);
+					// Nested objects push their keys behind this slice, so it is walked by position.
+					for (size_t pos = first; pos < last; pos++) {
+						if (pos != first) {
+							buffer_ += ',';
+						}
+						const auto &[key, value] = *keys_[pos];
+						_WriteString(key);
+						buffer_ += ':';
+						write(value);
+					}
+					keys_.resize(first);
+					buffer_ += '}';
+				}
+
+			private:
+				std::string &buffer_;
+				std::vector<const JSONObject::Entry*> &keys_;
+
+				template <typename _Integer>
+				void _WriteInteger(const _Integer &value)
+				{
+					char chars[24];
+					auto result = std::to_chars(chars, chars + sizeof(chars), value);
+					buffer_.append(chars, result.ptr);
+				}
+
+				// ECMAScript Number::toString over the shortest round-trip digits.
+				void _WriteDouble(const double &value)
+				{
+					if (!std::isfinite(value)) {
+						throw JSONExcept("NaN and infinity have no canonical form");
+					}
+					if (value == 0.0) {
+						buffer_ += '0';
+						return;
+					}
+					char chars[32];
+					auto result = std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::scientific);
+					const char* cur = chars;
+					if (*cur == '-') {
+						buffer_ += '-';
+						cur++;
+					}
+					char digits[20];
+					int count = 0;
+					for (; cur != result.ptr && *cur != 'e'; cur++) {
+						if (*cur != '.') {
+							digits[count++] = *cur;
+						}
+					}
+					cur++;
+					if (cur != result.ptr && *cur == '+') {
+						cur++;
+					}
+					int exponent = 0;
+					std::from_chars(cur, result.ptr, exponent);
+					const int point = exponent + 1;
+					if (count <= point && point <= 21) {
+						buffer_.append(digits, count);
+						buffer_.append(static_cast<size_t>(point - count), '0');
+					} else if (0 < point && point <= 21) {
+						buffer_.append(digits, point);
+						buffer_ += '.';
+						buffer_.append(digits + point, count - point);
+					} else if (-6 < point && point <= 0) {
+						buffer_ += "0.";
+						buffer_.append(static_cast<size_t>(-point), '0');
+						buffer_.append(digits, count);
+					} else {
+						buffer_ += digits[0];
+						if (count > 1) {
+							buffer_ += '.';
+							buffer_.append(digits + 1, count - 1);
+						}
+						buffer_ += (point - 1 < 0) ? "e-" : "e+";
+						_WriteInteger(std::abs(point - 1));
+					}
+				}
+
+				void _WriteString(const std::string_view &str)
+				{
+					static const char hexDigits[] = "0123456789abcdef";
+
+					buffer_ += '\"';
+					auto run = str.data();
+					const auto end = str.data() + str.size();
+					for (auto cur = run; cur != end; cur++) {
+						const auto ch = static_cast<uint8_t>(*cur);
+						if (ch >= 0x20 && ch != '\"' && ch != '\\') {
+							continue;
+						}
+						buffer_.append(run, cur);
+						run = cur + 1;
+						switch (ch) {
+							case '\"':
+								buffer_ += "\\\"";
+								break;
+							case '\\':
+								buffer_ += "\\\\";
+								break;
+							case '\b':
+								buffer_ += "\\b";
+								break;
+							case '\f':
+								buffer_ += "\\f";
+								break;
+							case '\n':
+								buffer_ += "\\n";
+								break;
+							case '\r':
+								buffer_ += "\\r";
+								break;
+							case '\t':
+								buffer_ += "\\t";
+								break;
+							default:
+								buffer_ += "\\u00";
+								buffer_ += hexDigits[ch >> 4];
+								buffer_ += hexDigits[ch & 0xF];
+								break;
+						}
+					}
+					buffer_.append(run, end);
+					buffer_ += '\"';
+				}
+		};
+
+		template <typename _Value>
+		void _Write(const _Value &value, std::string &buffer)
+		{
+			_CU_STATS_PHASE(SERIALIZE, 0);
+			const auto begin = buffer.size();
+			_CanonicalWriter(buffer).write(value);
+			_CU_STATS_OUTPUT(buffer.size() - begin);
+			(void)begin;
+		}
+	}
+}
+
+void CU::WriteCanonical(const JSONItem &item, std::string &buffer)
+{
+	_Write(item, buffer);
+}
+
+void CU::WriteCanonical(const JSONArray &array, std::string &buffer)
+{
+	_Write(array, buffer);
+}
+
+void CU::WriteCanonical(const JSONObject &object, std::string &buffer)
+{
+	_Write(object, buffer);
+}
+
+std::string CU::ToCanonicalString(const JSONItem &item)
+{
+	std::string buffer{};
+	_Write(item, buffer);
+	return buffer;
+}
+
+std::string CU::ToCanonicalString(const JSONArray &array)
+{
+	std::string buffer{};
+	_Write(array, buffer);
+	return buffer;
+}
+
+std::string CU::ToCanonicalString(const JSONObject &object)
+{
+	std::string buffer{};
+	_Write(object, buffer);
+	return buffer;
+}
@@ -0,0 +1,24 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONCANONICAL_
+#define _CU_JSONCANONICAL_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	// RFC 8785 (JCS) style output: no whitespace, object keys sorted by UTF-16 code units,
+	// doubles in the shortest form that round-trips (ECMAScript notation) and only the
+	// escapes JSON requires. Integers are written exactly, also beyond 2^53.
+	// Equal documents give byte-identical text. NaN and infinity throw JSONExcept.
+	void WriteCanonical(const JSONItem &item, std::string &buffer);
+	void WriteCanonical(const JSONArray &array, std::string &buffer);
+	void WriteCanonical(const JSONObject &object, std::string &buffer);
+
+	std::string ToCanonicalString(const JSONItem &item);
+	std::string ToCanonicalString(const JSONArray &array);
+	std::string ToCanonicalString(const JSONObject &object);
+}
+
+#endif // _CU_JSONCANONICAL_
@@ -0,0 +1,306 @@
+#include "CuJSONColumnar.h"
+#include "CuJSONParser.h"
+#include <deque>
+
+namespace CU
+{
+	namespace
+	{
+		struct _ColumnState
+		{
+			size_t filled;
+			size_t firstRow;
+			size_t firstPos;
+			std::deque<std::string> strings;
+			std::unordered_map<std::string_view, uint32_t> codes;
+		};
+
+		void _SetValid(JSONColumn &column, const size_t &row)
+		{
+			column.validity[row / 64] |= (uint64_t(1) << (row % 64));
+		}
+
+		// Keeps the slot vector of the column's type as long as the rows filled so far.
+		void _Grow(JSONColumn &column, const size_t &rows)
+		{
+			column.validity.resize((rows + 63) / 64, 0);
+			switch (column.type) {
+				case ColumnType::BOOLEAN:
+					column.booleans.resize(rows, 0);
+					break;
+				case ColumnType::LONG:
+					column.longs.resize(rows, 0);
+					break;
+				case ColumnType::DOUBLE:
+					column.doubles.resize(rows, 0.0);
+					break;
+				case ColumnType::STRING:
+					column.codes.resize(rows, 0);
+					break;
+				case ColumnType::MIXED:
+					column.items.resize(rows);
+					break;
+				default:
+					break;
+			}
+		}
+
+		// Moves the values seen so far into JSONItems, once the field turns out to be mixed.
+		void _ToMixed(JSONColumn &column, _ColumnState &state, const size_t &rows)
+		{
+			column.items.resize(rows);
+			for (size_t row = 0; row < rows; row++) {
+				if (!column.valid(row)) {
+					continue;
+				}
+				switch (column.type) {
+					case ColumnType::BOOLEAN:
+						column.items[row] = JSONItem(column.booleans[row] != 0);
+						break;
+					case ColumnType::LONG:
+						column.items[row] = JSONItem(column.longs[row]);
+						break;
+					case ColumnType::DOUBLE:
+						column.items[row] = JSONItem(column.doubles[row]);
+						break;
+					case ColumnType::STRING:
+						column.items[row] = JSONItem(state.strings[column.codes[row]]);
+						break;
+					default:
+						break;
+				}
+			}
+			column.booleans = std::vector<uint8_t>();
+			column.longs = std::vector<int64_t>();
+			column.doubles = std::vector<double>();
+			column.codes = std::vector<uint32_t>();
+			state.codes.clear();
+			state.strings.clear();
+			column.type = ColumnType::MIXED;
+		}
+
+		ColumnType _ValueType(const ItemType &type) noexcept
+		{
+			switch (type) {
+				case ItemType::ITEM_NULL:
+					return ColumnType::COLUMN_NULL;
+				case ItemType::BOOLEAN:
+					return ColumnType::BOOLEAN;
+				case ItemType::INTEGER:
+				case ItemType::LONG:
+					return ColumnType::LONG;
+				case ItemType::DOUBLE:
+					return ColumnType::DOUBLE;
+				case ItemType::STRING:
+					return ColumnType::STRING;
+				default:
+					break;
+			}
+			return ColumnType::MIXED;
+		}
+	}
+
+	// Walks the members of each record in order without a hash lookup per value: the field
+	// seen at the same member position in the previous record is tried first.
+	class _ColumnBuilder
+	{
+		public:
+			_ColumnBuilder() : rows_(0), columns_(), states_(), index_(), slots_(), probe_() { }
+
+			void add(const JSONObject &record)
+			{
+				size_t pos = 0;
+				for (const auto &[key, value] : record) {
+					_Append(_Column(key, pos), value);
+					pos++;
+				}
+				rows_++;
+			}
+
+			JSONColumns finish()
+			{
+				std::vector<size_t> order(columns_.size());
+				for (size_t column = 0; column < columns_.size(); column++) {
+					order[column] = column;
+					if (states_[column].filled < rows_) {
+						columns_[column].missingCount += rows_ - states_[column].filled;
+						_Grow(columns_[column], rows_);
+					}
+					auto &state = states_[column];
+					if (columns_[column].type == ColumnType::STRING) {
+						columns_[column].dictionary.assign(state.strings.begin(), state.strings.end());
+					}
+				}
+				std::sort(order.begin(), order.end(), [this](const size_t &column, const size_t &other) {
+					const auto &state = states_[column];
+					const auto &otherState = states_[other];
+					if (state.firstRow != otherState.firstRow) {
+						return (state.firstRow < otherState.firstRow);
+					}
+					return (state.firstPos < otherState.firstPos);
+				});
+				JSONColumns result{};
+				result.rows = rows_;
+				result.columns.reserve(columns_.size());
+				for (const auto &column : order) {
+					result.columns.emplace_back(std::move(columns_[column]));
+				}
+				return result;
+			}
+
+		private:
+			size_t rows_;
+			std::vector<JSONColumn> columns_;
+			// A deque, so the dictionaries never move and their string_view keys stay valid.
+			std::deque<_ColumnState> states_;
+			std::unordered_map<std::string, size_t> index_;
+			std::vector<size_t> slots_;
+			std::string probe_;
+
+			size_t _Column(const std::pmr::string &key, const size_t &pos)
+			{
+				if (pos < slots_.size() && std::string_view(columns_[slots_[pos]].name) == std::string_view(key)) {
+					return slots_[pos];
+				}
+				probe_.assign(key.data(), key.size());
+				auto iter = index_.find(probe_);
+				if (iter == index_.end()) {
+					iter = index_.emplace(probe_, columns_.size()).first;
+					JSONColumn column{};
+					column.name = probe_;
+					column.type = ColumnType::COLUMN_NULL;
+					column.nullCount = 0;
+					column.missingCount = rows_;
+					_Grow(column, rows_);
+					columns_.emplace_back(std::move(column));
+					states_.emplace_back(_ColumnState{rows_, rows_, pos, {}, {}});
+				}
+				if (pos >= slots_.size()) {
+					slots_.resize(pos + 1);
+				}
+				slots_[pos] = iter->second;
+				return iter->second;
+			}
+
+			void _Append(const size_t &index, const JSONItem &value)
+			{
+				auto &column = columns_[index];
+				auto &state = states_[index];
+				if (state.filled < rows_) {
+					column.missingCount += rows_ - state.filled;
+				}
+				const auto row = rows_;
+				state.filled = row + 1;
+				const auto type = _ValueType(value.type());
+				if (type == ColumnType::COLUMN_NULL) {
+					column.nullCount++;
+					_Grow(column, row + 1);
+					return;
+				}
+				if (column.type == ColumnType::COLUMN_NULL) {
+					column.type = type;
+				} else if (column.type == ColumnType::LONG && type == ColumnType::DOUBLE) {
+					column.doubles.assign(column.longs.begin(), column.longs.end());
+					column.longs = std::vector<int64_t>();
+					column.type = ColumnType::DOUBLE;
+				} else if (column.type != type && column.type != ColumnType::MIXED && !(column.type == ColumnType::DOUBLE && type == ColumnType::LONG)) {
+					_ToMixed(column, state, row);
+				}
+				_Grow(column, row + 1);
+				_SetValid(column, row);
+				switch (column.type) {
+					case ColumnType::BOOLEAN:
+						column.booleans[row] = value.toBoolean() ? 1 : 0;
+						break;
+					case ColumnType::LONG:
+						column.longs[row] = (value.type() == ItemType::INTEGER) ? value.toInt() : value.toLong();
+						break;
+					case ColumnType::DOUBLE:
+						if (value.type() == ItemType::INTEGER) {
+							column.doubles[row] = value.toInt();
+						} else if (value.type() == ItemType::LONG) {
+							column.doubles[row] = static_cast<double>(value.toLong());
+						} else {
+							column.doubles[row] = value.toDouble();
+						}
+						break;
+					case ColumnType::STRING:
+						column.codes[row] = _Code(state, value.asString());
+						break;
+					default:
+						column.items[row] = value;
+						break;
+				}
+			}
+
+			uint32_t _Code(_ColumnState &state, const std::string_view &str)
+			{
+				const auto iter = state.codes.find(str);
+				if (iter != state.codes.end()) {
+					return iter->second;
+				}
+				const auto code = static_cast<uint32_t>(state.strings.size());
+				state.strings.emplace_back(str);
+				state.codes.emplace(state.strings.back(), code);
+				return code;
+			}
+	};
+}
+
+bool CU::JSONColumn::valid(const size_t &row) const
+{
+	return ((validity[row / 64] >> (row % 64)) & 1) != 0;
+}
+
+const CU::JSONColumn* CU::JSONColumns::find(const std::string_view &name) const
+{
+	for (const auto &column : columns) {
+		if (column.name == name) {
+			return std::addressof(column);
+		}
+	}
+	return nullptr;
+}
+
+CU::JSONColumns CU::ToColumns(const JSONArray &records)
+{
+	_ColumnBuilder builder{};
+	for (const auto &record : records) {
+		if (record.type() != ItemType::OBJECT) {
+			throw JSONExcept("Record is not a JSONObject");
+		}
+		builder.add(record.asObject());
+	}
+	return builder.finish();
+}
+
+CU::JSONColumns CU::ReadColumns(const std::string_view &text)
+{
+	_ColumnBuilder builder{};
+	JSONParser parser{};
+	JSONDocument document{};
+	size_t line = 0;
+	size_t pos = 0;
+	while (pos < text.size()) {
+		auto end = text.find('\n', pos);
+		if (end == std::string_view::npos) {
+			end = text.size();
+		}
+		const auto record = text.substr(pos, end - pos);
+		line++;
+		pos = end + 1;
+		if (record.find_first_not_of(" \t\r") == std::string_view::npos) {
+			continue;
+		}
+		try {
+			parser.parse(record, document);
+		} catch (const JSONExcept &e) {
+			throw JSONExcept("Line " + std::to_string(line) + ": " + e.what());
+		}
+		if (document.root().type() != ItemType::OBJECT) {
+			throw JSONExcept("Line " + std::to_string(line) + ": Record is not a JSONObject");
+		}
+		builder.add(document.object());
+	}
+	return builder.finish();
+}
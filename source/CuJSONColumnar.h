@@ -0,0 +1,51 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONCOLUMNAR_
+#define _CU_JSONCOLUMNAR_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	// LONG holds INTEGER and LONG values, DOUBLE any mix of numbers. Fields holding
+	// containers or values of different kinds are MIXED; COLUMN_NULL fields never hold a value.
+	enum class ColumnType : uint8_t {COLUMN_NULL, BOOLEAN, LONG, DOUBLE, STRING, MIXED};
+
+	// One field of the records, one slot per row in the vector of its type. validity has
+	// a bit per row, set when the row holds a value; null and missing rows keep 0 / false /
+	// code 0 in their slot. Strings are dictionary encoded in first seen order.
+	struct JSONColumn
+	{
+		std::string name;
+		ColumnType type;
+		size_t nullCount;
+		size_t missingCount;
+		std::vector<uint64_t> validity;
+		std::vector<uint8_t> booleans;
+		std::vector<int64_t> longs;
+		std::vector<double> doubles;
+		std::vector<uint32_t> codes;
+		std::vector<std::string> dictionary;
+		std::vector<JSONItem> items;
+
+		bool valid(const size_t &row) const;
+	};
+
+	// Columns are ordered by the first record holding each field, then by member order.
+	struct JSONColumns
+	{
+		size_t rows;
+		std::vector<JSONColumn> columns;
+
+		const JSONColumn* find(const std::string_view &name) const;
+	};
+
+	// Converts an array of JSONObject records in one pass, without copying the records.
+	// Throws JSONExcept when an element is not an object.
+	JSONColumns ToColumns(const JSONArray &records);
+	// Same for NDJSON text, one record per line; blank lines are skipped.
+	JSONColumns ReadColumns(const std::string_view &text);
+}
+
+#endif // _CU_JSONCOLUMNAR_
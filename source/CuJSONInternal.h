@@ -0,0 +1,35 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONINTERNAL_
+#define _CU_JSONINTERNAL_
+
+#include "CuJSONParser.h"
+
+// Helpers shared by the translation units of the library, not part of its interface.
+namespace CU
+{
+	inline bool _IsSpace(const char &ch) noexcept
+	{
+		switch (ch) {
+			case ' ':
+			case '\n':
+			case '\t':
+			case '\r':
+			case '\f':
+			case '\a':
+			case '\b':
+			case '\v':
+				return true;
+			default:
+				break;
+		}
+		return false;
+	}
+
+	// One parser per thread with the default JSONParser::Options, for the string
+	// constructors and the slices matched by JSONPointer / JSONPath.
+	JSONParser &_ThreadParser();
+}
+
+#endif // _CU_JSONINTERNAL_
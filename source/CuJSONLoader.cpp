@@ -0,0 +1,209 @@
+#include "CuJSONLoader.h"
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace CU
+{
+	namespace
+	{
+		class _File
+		{
+			public:
+				_File(const std::string &path) : fd_(-1)
+				{
+#if defined(_WIN32)
+					fd_ = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+					fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+					if (fd_ < 0) {
+						throw JSONExcept("Failed to open " + path + ": " + std::strerror(errno));
+					}
+				}
+
+				~_File()
+				{
+#if defined(_WIN32)
+					_close(fd_);
+#else
+					close(fd_);
+#endif
+				}
+
+				_File(const _File &) = delete;
+				_File &operator=(const _File &) = delete;
+
+				// Returns 0 at the end of the file.
+				size_t read(char* buffer, const size_t &size)
+				{
+					for (;;) {
+#if defined(_WIN32)
+						const auto length = _read(fd_, buffer, static_cast<unsigned int>(std::min<size_t>(size, INT_MAX)));
+#else
+						const auto length = ::read(fd_, buffer, size);
+#endif
+						if (length >= 0) {
+							return static_cast<size_t>(length);
+						} else if (errno != EINTR) {
+							throw JSONExcept(std::string("Failed to read JSON: ") + std::strerror(errno));
+						}
+					}
+				}
+
+			private:
+				int fd_;
+		};
+
+		// Single producer, single consumer ring of equally sized blocks.
+		class _BlockRing
+		{
+			public:
+				_BlockRing(const size_t &blockSize, const size_t &blockCount) :
+					blocks_(std::max<size_t>(blockCount, 1), std::string(std::max<size_t>(blockSize, 1), '\0')),
+					lengths_(blocks_.size(), 0),
+					mutex_(),
+					changed_(),
+					head_(0),
+					filled_(0),
+					closed_(false),
+					cancelled_(false),
+					error_()
+				{ }
+
+				// Reader side: a free block, or nullptr once the consumer gave up.
+				std::string* acquire()
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					changed_.wait(lock, [this]() { return (filled_ < blocks_.size() || cancelled_); });
+					if (cancelled_) {
+						return nullptr;
+					}
+					return std::addressof(blocks_[(head_ + filled_) % blocks_.size()]);
+				}
+
+				void publish(const size_t &length)
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						lengths_[(head_ + filled_) % blocks_.size()] = length;
+						filled_++;
+					}
+					changed_.notify_all();
+				}
+
+				void close(const std::exception_ptr &error)
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						closed_ = true;
+						error_ = error;
+					}
+					changed_.notify_all();
+				}
+
+				// Consumer side: the next filled block, false at the end of the file.
+				bool next(std::string_view &block)
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					changed_.wait(lock, [this]() { return (filled_ != 0 || closed_); });
+					if (filled_ == 0) {
+						if (error_) {
+							std::rethrow_exception(error_);
+						}
+						return false;
+					}
+					block = std::string_view(blocks_[head_].data(), lengths_[head_]);
+					return true;
+				}
+
+				void release()
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						head_ = (head_ + 1) % blocks_.size();
+						filled_--;
+					}
+					changed_.notify_all();
+				}
+
+				void cancel()
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						cancelled_ = true;
+					}
+					changed_.notify_all();
+				}
+
+			private:
+				std::vector<std::string> blocks_;
+				std::vector<size_t> lengths_;
+				std::mutex mutex_;
+				std::condition_variable changed_;
+				size_t head_;
+				size_t filled_;
+				bool closed_;
+				bool cancelled_;
+				std::exception_ptr error_;
+		};
+
+		void _ReadBlocks(_File &file, _BlockRing &ring)
+		{
+			try {
+				for (auto block = ring.acquire(); block != nullptr; block = ring.acquire()) {
+					const auto length = file.read(block->data(), block->size());
+					if (length == 0) {
+						break;
+					}
+					ring.publish(length);
+				}
+				ring.close(nullptr);
+			} catch (...) {
+				ring.close(std::current_exception());
+			}
+		}
+
+		JSONItem _Load(const std::string &path, const JSONLoadOptions &options, std::pmr::memory_resource* resource)
+		{
+			JSONMemoryScope scope(resource);
+			_File file(path);
+			_BlockRing ring(options.blockSize, options.blockCount);
+			std::thread reader(_ReadBlocks, std::ref(file), std::ref(ring));
+			JSONItem item{};
+			try {
+				JSONParser parser(options.parserOptions);
+				parser.begin(item);
+				std::string_view block{};
+				while (ring.next(block)) {
+					parser.feed(block);
+					ring.release();
+				}
+				parser.finish();
+			} catch (...) {
+				ring.cancel();
+				reader.join();
+				throw;
+			}
+			reader.join();
+			return item;
+		}
+	}
+}
+
+CU::JSONLoadOptions::JSONLoadOptions() : blockSize(1 << 20), blockCount(4), parserOptions(), resource(nullptr) { }
+
+std::future<CU::JSONItem> CU::LoadAsync(const std::string &path, const JSONLoadOptions &options)
+{
+	const auto resource = (options.resource != nullptr) ? options.resource : std::pmr::new_delete_resource();
+	return std::async(std::launch::async, _Load, path, options, resource);
+}
@@ -0,0 +1,34 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONLOADER_
+#define _CU_JSONLOADER_
+
+#include "CuJSONParser.h"
+#include <future>
+
+namespace CU
+{
+	struct JSONLoadOptions
+	{
+		size_t blockSize;
+		size_t blockCount;
+		JSONParser::Options parserOptions;
+		// Where the values are allocated, from the loading thread while the caller goes on, so
+		// it must be thread-safe or left alone until the future is ready. nullptr allocates
+		// from std::pmr::new_delete_resource().
+		std::pmr::memory_resource* resource;
+
+		JSONLoadOptions();
+	};
+
+	// Loads a JSON file with the reading and the parsing overlapped: a reader thread fills a
+	// ring of blockCount buffers of blockSize bytes with read() while the loading thread feeds
+	// every filled buffer to an incremental JSONParser, so only the ring and the unparsed tail
+	// are held besides the tree. The future holds the root, or the JSONExcept of an I/O error
+	// or invalid text. The current memory resource of the caller is not used, it may not be
+	// safe to share with another thread; see JSONLoadOptions::resource.
+	std::future<JSONItem> LoadAsync(const std::string &path, const JSONLoadOptions &options = JSONLoadOptions());
+}
+
+#endif // _CU_JSONLOADER_
@@ -1,77 +1,280 @@
 #include "CuJSONObject.h"
+#include "CuJSONInternal.h"
+#include "CuJSONStats.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace CU
+{
+	namespace
+	{
+		thread_local std::pmr::memory_resource* currentResource = nullptr;
+
+		std::pmr::string _ToKey(const std::string_view &key)
+		{
+			return std::pmr::string(key.data(), key.size(), GetMemoryResource());
+		}
 
-CU::JSONItem::_Init_Val CU::JSONItem::_To_Init_Val(const std::string &JSONRaw)
-{
-	static const auto createInitVal = [](const ItemType &type, const ItemValue &value) -> _Init_Val {
-		_Init_Val initVal{};
-		initVal.type = type;
-		initVal.value = value;
-		return initVal;
-	};
-
-	switch (JSONRaw.front()) {
-		case '{':
-			if (JSONRaw.back() == '}') {
-				return createInitVal(ItemType::OBJECT, new JSONObject(JSONRaw));
-			}
-			break;
-		case '[':
-			if (JSONRaw.back() == ']') {
-				return createInitVal(ItemType::ARRAY, new JSONArray(JSONRaw));
+		// Lookups only need a key to compare against, the buffer is reused instead of allocating one per call.
+		const std::pmr::string &_ProbeKey(const std::string_view &key)
+		{
+			thread_local std::pmr::string probe{};
+			probe.assign(key.data(), key.size());
+			return probe;
+		}
+
+		// Containers with less text are written again every time: copying a cached text
+		// would not be cheaper than writing it.
+		constexpr size_t _MinCachedText = 256;
+
+		constexpr uint64_t _HashSeed = 0x9E3779B97F4A7C15ULL;
+
+		inline uint64_t _HashMix(uint64_t value) noexcept
+		{
+			value ^= value >> 30;
+			value *= 0xBF58476D1CE4E5B9ULL;
+			value ^= value >> 27;
+			value *= 0x94D049BB133111EBULL;
+			value ^= value >> 31;
+			return value;
+		}
+
+		inline uint64_t _HashCombine(const uint64_t &seed, const uint64_t &value) noexcept
+		{
+			return _HashMix(seed ^ (value + _HashSeed + (seed << 6) + (seed >> 2)));
+		}
+
+		// Eight bytes per round, independent of std::hash so the values are the same in every build.
+		uint64_t _HashBytes(const std::string_view &bytes) noexcept
+		{
+			uint64_t hash = _HashMix(_HashSeed ^ bytes.size());
+			size_t pos = 0;
+			for (; pos + 8 <= bytes.size(); pos += 8) {
+				uint64_t block = 0;
+				std::memcpy(&block, bytes.data() + pos, 8);
+				hash = _HashCombine(hash, block);
 			}
-			break;
-		case '\"':
-			if (JSONRaw.back() == '\"') {
-				return createInitVal(ItemType::STRING, JSONRaw.substr(1, JSONRaw.size() - 2));
+			if (pos < bytes.size()) {
+				uint64_t block = 0;
+				std::memcpy(&block, bytes.data() + pos, bytes.size() - pos);
+				hash = _HashCombine(hash, block);
 			}
-			break;
-		case '-':
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			{
-				auto num = atof(JSONRaw.c_str());
-				if (num != 0) {
-					if (num == static_cast<int64_t>(num)) {
-						if (num > static_cast<double>(INT_MAX) || num < static_cast<double>(INT_MIN)) {
-							return createInitVal(ItemType::LONG, static_cast<int64_t>(num));
-						} else {
-							return createInitVal(ItemType::INTEGER, static_cast<int>(num));
-						}
-					} else {
-						return createInitVal(ItemType::DOUBLE, num);
-					}
-				} else if (JSONRaw == "0") {
-					return createInitVal(ItemType::INTEGER, 0);
-				} else if (JSONRaw == "0.0") {
-					return createInitVal(ItemType::DOUBLE, 0.0);
+			return hash;
+		}
+
+		// Length of _AppendJSONRaw()'s output.
+		size_t _JSONRawSize(const std::string_view &str) noexcept
+		{
+			size_t size = str.size() + 2;
+			for (const auto &ch : str) {
+				switch (ch) {
+					case '\\':
+					case '\"':
+					case '\'':
+					case '\n':
+					case '\t':
+					case '\r':
+					case '\f':
+					case '\a':
+					case '\b':
+					case '\v':
+					case '/':
+						size++;
+						break;
+					default:
+						break;
 				}
 			}
-			break;
-		case 't':
-		case 'f':
-			if (JSONRaw == "true") {
-				return createInitVal(ItemType::BOOLEAN, true);
-			} else if (JSONRaw == "false") {
-				return createInitVal(ItemType::BOOLEAN, false);
+			return size;
+		}
+
+		template <typename _Integer>
+		size_t _IntegerSize(const _Integer &value) noexcept
+		{
+			char chars[24];
+			return static_cast<size_t>(std::to_chars(chars, chars + sizeof(chars), value).ptr - chars);
+		}
+
+		// Length of "%f" without formatting: sign, integer digits after rounding to six
+		// decimals, and ".dddddd". Huge, non-finite and borderline values are formatted.
+		size_t _DoubleSize(const double &value) noexcept
+		{
+			const double magnitude = std::fabs(value);
+			if (!(magnitude < 1e15)) {
+				return static_cast<size_t>(snprintf(nullptr, 0, "%f", value));
 			}
-			break;
-		case 'n':
-			if (JSONRaw == "null") {
-				return createInitVal(ItemType::ITEM_NULL, ItemNull());
+			auto integral = static_cast<uint64_t>(magnitude);
+			const double fraction = magnitude - static_cast<double>(integral);
+			if (std::fabs(fraction - 0.9999995) < 1e-9) {
+				return static_cast<size_t>(snprintf(nullptr, 0, "%f", value));
+			} else if (fraction > 0.9999995) {
+				integral++;
 			}
+			return (std::signbit(value) ? 1 : 0) + _IntegerSize(integral) + 7;
+		}
+
+		// The parser only keeps numbers it has checked, so only DOUBLE ones can fail, when
+		// they are out of range; they convert like the eager parser does.
+		template <typename _Number>
+		_Number _RawValue(const _RawNumber &raw) noexcept
+		{
+			_Number value{};
+			const auto text = raw.view();
+			[[maybe_unused]] const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+			if constexpr (std::is_floating_point_v<_Number>) {
+				if (result.ec == std::errc::result_out_of_range) {
+					value = strtod(std::string(text).c_str(), nullptr);
+				}
+			}
+			return value;
+		}
+
+		// Counts the buffer of a string in category, nothing while the text fits in the
+		// string object itself.
+		void _CountString(const std::pmr::string &str, size_t &category, size_t &slack) noexcept
+		{
+			const auto data = reinterpret_cast<uintptr_t>(str.data());
+			const auto self = reinterpret_cast<uintptr_t>(std::addressof(str));
+			if (data >= self && data < self + sizeof(str)) {
+				return;
+			}
+			category += str.size() + 1;
+			slack += str.capacity() - str.size();
+		}
+
+		// Keeps the total of what it hands out, to measure what the map allocates.
+		class _ProbeResource : public std::pmr::memory_resource
+		{
+			public:
+				size_t allocated = 0;
+
+			private:
+				void* do_allocate(size_t bytes, size_t alignment) override
+				{
+					allocated += bytes;
+					return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+				}
+
+				void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+				{
+					std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+				}
+
+				bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+				{
+					return this == &other;
+				}
+		};
+
+		// The links a map node keeps next to the member differ between libraries, and whether
+		// the hash code is cached too. Measured once as what a short key added to a map with
+		// its buckets in place costs.
+		size_t _MapNodeSize()
+		{
+			static const size_t size = [] {
+				_ProbeResource probe{};
+				std::pmr::unordered_map<std::pmr::string, JSONItem> map(&probe);
+				map.reserve(1);
+				const auto allocated = probe.allocated;
+				map.emplace(std::piecewise_construct, std::forward_as_tuple("k"), std::forward_as_tuple());
+				return probe.allocated - allocated;
+			}();
+			return size;
+		}
+
+		// 0 marks a container hash as not computed yet.
+		inline size_t _HashValue(const uint64_t &hash) noexcept
+		{
+			auto value = static_cast<size_t>(hash);
+			return (value != 0) ? value : 1;
+		}
+	}
+}
+
+size_t CU::JSONMemoryUsage::total() const noexcept
+{
+	return nodes + strings + buckets + order + slack;
+}
+
+CU::JSONMemoryUsage &CU::JSONMemoryUsage::operator+=(const JSONMemoryUsage &other) noexcept
+{
+	nodes += other.nodes;
+	strings += other.strings;
+	buckets += other.buckets;
+	order += other.order;
+	slack += other.slack;
+	return *this;
+}
+
+std::pmr::memory_resource* CU::GetMemoryResource() noexcept
+{
+	if (currentResource == nullptr) {
+		return std::pmr::get_default_resource();
+	}
+	return currentResource;
+}
+
+CU::JSONMemoryScope::JSONMemoryScope(std::pmr::memory_resource* resource) : prev_(currentResource)
+{
+	currentResource = resource;
+}
+
+CU::JSONMemoryScope::~JSONMemoryScope()
+{
+	currentResource = prev_;
+}
+
+CU::_JSONCache::~_JSONCache()
+{
+	delete text_.load(std::memory_order_relaxed);
+}
+
+// Stops at the first container with nothing cached, nothing above it can have caches left.
+// Checked before writing, so handing out references of a clean container stays cheap.
+void CU::_JSONCache::_Invalidate() const noexcept
+{
+	for (auto node = this; node != nullptr; node = node->parent_.load(std::memory_order_relaxed)) {
+		if (node->hash_.load(std::memory_order_relaxed) == 0 && node->textSize_.load(std::memory_order_relaxed) == 0 &&
+			node->text_.load(std::memory_order_relaxed) == nullptr) {
 			break;
-		default:
-			break;
+		}
+		node->hash_.store(0, std::memory_order_relaxed);
+		node->textSize_.store(0, std::memory_order_relaxed);
+		delete node->text_.exchange(nullptr, std::memory_order_relaxed);
 	}
-	throw JSONExcept("Invalid JSONItem");
+}
+
+void CU::_JSONCache::_Adopt(const JSONItem &item) const noexcept
+{
+	if (item.type_ == ItemType::ARRAY) {
+		static_cast<const _JSONCache*>(std::get<JSONArray*>(item.value_))->parent_.store(this, std::memory_order_relaxed);
+	} else if (item.type_ == ItemType::OBJECT) {
+		static_cast<const _JSONCache*>(std::get<JSONObject*>(item.value_))->parent_.store(this, std::memory_order_relaxed);
+	}
+}
+
+// other is left empty, so its caches and those of its parents are dropped.
+void CU::_JSONCache::_TakeCache(_JSONCache &other) noexcept
+{
+	hash_.store(other.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	textSize_.store(other.textSize_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	text_.store(other.text_.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+	cacheText_.store(other.cacheText_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	other._Invalidate();
+}
+
+CU::JSONItem::_Init_Val CU::JSONItem::_To_Init_Val(const std::string &JSONRaw)
+{
+	JSONItem item{};
+	_ThreadParser().parse(JSONRaw, item);
+	_Init_Val initVal{};
+	initVal.type = item.type_;
+	initVal.value = std::move(item.value_);
+	item.type_ = ItemType::ITEM_NULL;
+	item.value_ = ItemNull();
+	return initVal;
 }
 
 CU::JSONItem::JSONItem() : 
@@ -101,87 +304,70 @@ CU::JSONItem::JSONItem(const double &value) :
 
 CU::JSONItem::JSONItem(const char* value) :
 	type_(ItemType::STRING),
-	value_(std::string(value))
+	value_(std::pmr::string(value, GetMemoryResource()))
 { }
 
 CU::JSONItem::JSONItem(const std::string &value) :
 	type_(ItemType::STRING),
-	value_(value)
+	value_(std::pmr::string(value.data(), value.size(), GetMemoryResource()))
 { }
 
 CU::JSONItem::JSONItem(const JSONArray &value) :
 	type_(ItemType::ARRAY),
-	value_(new JSONArray(value))
+	value_(_NewNode<JSONArray>(value))
 { }
 
 CU::JSONItem::JSONItem(const JSONObject &value) :
 	type_(ItemType::OBJECT),
-	value_(new JSONObject(value))
+	value_(_NewNode<JSONObject>(value))
+{ }
+
+// Takes the content over, copying only when value lives in another memory resource.
+CU::JSONItem::JSONItem(JSONArray &&value) :
+	type_(ItemType::ARRAY),
+	value_(_NewNode<JSONArray>(std::move(value)))
+{ }
+
+CU::JSONItem::JSONItem(JSONObject &&value) :
+	type_(ItemType::OBJECT),
+	value_(_NewNode<JSONObject>(std::move(value)))
 { }
 
 CU::JSONItem::JSONItem(const JSONItem &other) :
-	type_(other.type()),
+	type_(ItemType::ITEM_NULL),
 	value_(ItemNull())
 {
 	if (std::addressof(other) == this) {
 		return;
 	}
-	const auto &other_value = other.value();
-	if (type_ == ItemType::ARRAY) {
-		const auto &jsonArray = *(std::get<JSONArray*>(other_value));
-		value_ = new JSONArray(jsonArray);
-	} else if (type_ == ItemType::OBJECT) {
-		const auto &jsonObject = *(std::get<JSONObject*>(other_value));
-		value_ = new JSONObject(jsonObject);
-	} else {
-		value_ = other_value;
-	}
+	_CopyValue(other);
 }
 
 CU::JSONItem::JSONItem(JSONItem &&other) noexcept :
-	type_(other.type()),
-	value_(ItemNull())
+	type_(other.type_),
+	value_(std::move(other.value_))
 {
-	if (std::addressof(other) == this) {
-		return;
-	}
-	const auto &other_value = other.value();
-	if (type_ == ItemType::ARRAY) {
-		const auto &jsonArray = *(std::get<JSONArray*>(other_value));
-		value_ = new JSONArray(jsonArray);
-	} else if (type_ == ItemType::OBJECT) {
-		const auto &jsonObject = *(std::get<JSONObject*>(other_value));
-		value_ = new JSONObject(jsonObject);
-	} else {
-		value_ = other_value;
-	}
+	other.type_ = ItemType::ITEM_NULL;
+	other.value_ = ItemNull();
+	_Detach();
 }
 
 CU::JSONItem::JSONItem(_Init_Val &&initVal) noexcept :
 	type_(initVal.type),
-	value_(initVal.value)
+	value_(std::move(initVal.value))
 { }
 
+// The owner is being destroyed or already knows of the change.
 CU::JSONItem::~JSONItem()
 {
-	clear();
+	_Release();
 }
 
 CU::JSONItem &CU::JSONItem::operator()(const JSONItem &other)
 {
 	if (std::addressof(other) != this) {
 		clear();
-		type_ = other.type();
-		const auto &other_value = other.value();
-		if (type_ == ItemType::ARRAY) {
-			const auto &jsonArray = *(std::get<JSONArray*>(other_value));
-			value_ = new JSONArray(jsonArray);
-		} else if (type_ == ItemType::OBJECT) {
-			const auto &jsonObject = *(std::get<JSONObject*>(other_value));
-			value_ = new JSONObject(jsonObject);
-		} else {
-			value_ = other_value;
-		}
+		_CopyValue(other);
 	}
 	return *this;
 }
@@ -190,29 +376,48 @@ CU::JSONItem &CU::JSONItem::operator=(const JSONItem &other)
 {
 	if (std::addressof(other) != this) {
 		clear();
-		type_ = other.type();
-		const auto &other_value = other.value();
-		if (type_ == ItemType::ARRAY) {
-			const auto &jsonArray = *(std::get<JSONArray*>(other_value));
-			value_ = new JSONArray(jsonArray);
-		} else if (type_ == ItemType::OBJECT) {
-			const auto &jsonObject = *(std::get<JSONObject*>(other_value));
-			value_ = new JSONObject(jsonObject);
-		} else {
-			value_ = other_value;
-		}
+		_CopyValue(other);
+	}
+	return *this;
+}
+
+CU::JSONItem &CU::JSONItem::operator=(JSONItem &&other) noexcept
+{
+	if (std::addressof(other) != this) {
+		clear();
+		type_ = other.type_;
+		value_ = std::move(other.value_);
+		other.type_ = ItemType::ITEM_NULL;
+		other.value_ = ItemNull();
+		_Detach();
 	}
 	return *this;
 }
 
 bool CU::JSONItem::operator==(const JSONItem &other) const
 {
-	return (value_ == other.value());
+	if (type_ != other.type_) {
+		return false;
+	}
+	switch (type_) {
+		case ItemType::ARRAY:
+			return (asArray() == other.asArray());
+		case ItemType::OBJECT:
+			return (asObject() == other.asObject());
+		case ItemType::STRING:
+			return (asString() == other.asString());
+		default:
+			break;
+	}
+	if (std::holds_alternative<_RawNumber>(value_) || std::holds_alternative<_RawNumber>(other.value_)) {
+		return (_Value() == other._Value());
+	}
+	return (value_ == other.value_);
 }
 
 bool CU::JSONItem::operator!=(const JSONItem &other) const
 {
-	return (value_ != other.value());
+	return !(*this == other);
 }
 
 CU::ItemType CU::JSONItem::type() const
@@ -222,25 +427,20 @@ CU::ItemType CU::JSONItem::type() const
 
 CU::ItemValue CU::JSONItem::value() const
 {
-	return value_;
+	return _Value();
 }
 
 void CU::JSONItem::clear()
 {
-	if (type_ == ItemType::ARRAY) {
-		delete std::get<JSONArray*>(value_);
-	} else if (type_ == ItemType::OBJECT) {
-		delete std::get<JSONObject*>(value_);
-	}
-	type_ = ItemType::ITEM_NULL;
-	value_ = ItemNull();
+	_Notify();
+	_Release();
 }
 
 size_t CU::JSONItem::size() const
 {
 	switch (type_) {
 		case ItemType::STRING:
-			return std::get<std::string>(value_).size();
+			return asString().size();
 		case ItemType::ARRAY:
 			return std::get<JSONArray*>(value_)->size();
 		case ItemType::OBJECT:
@@ -251,6 +451,158 @@ size_t CU::JSONItem::size() const
 	return 1;
 }
 
+size_t CU::JSONItem::hash() const
+{
+	uint64_t value = 0;
+	switch (type_) {
+		case ItemType::BOOLEAN:
+			value = std::get<bool>(value_) ? 1 : 0;
+			break;
+		case ItemType::INTEGER:
+			value = static_cast<uint64_t>(static_cast<int64_t>(toInt()));
+			break;
+		case ItemType::LONG:
+			value = static_cast<uint64_t>(toLong());
+			break;
+		case ItemType::DOUBLE:
+			{
+				// -0.0 == 0.0, so both hash alike.
+				double number = toDouble();
+				if (number == 0.0) {
+					number = 0.0;
+				}
+				std::memcpy(&value, &number, sizeof(value));
+			}
+			break;
+		case ItemType::STRING:
+			value = _HashBytes(asString());
+			break;
+		case ItemType::ARRAY:
+			value = std::get<JSONArray*>(value_)->hash();
+			break;
+		case ItemType::OBJECT:
+			value = std::get<JSONObject*>(value_)->hash();
+			break;
+		default:
+			break;
+	}
+	return _HashValue(_HashCombine(static_cast<uint64_t>(type_), value));
+}
+
+// Exact length of toRaw(), cached inside containers.
+size_t CU::JSONItem::serializedSize() const
+{
+	if (const auto raw = std::get_if<_RawNumber>(std::addressof(value_))) {
+		return raw->size;
+	}
+	switch (type_) {
+		case ItemType::ITEM_NULL:
+			return 4;
+		case ItemType::BOOLEAN:
+			return std::get<bool>(value_) ? 4 : 5;
+		case ItemType::INTEGER:
+			return _IntegerSize(std::get<int>(value_));
+		case ItemType::LONG:
+			return _IntegerSize(std::get<int64_t>(value_));
+		case ItemType::DOUBLE:
+			// toRaw() formats doubles with std::to_string(), which is defined as "%f".
+			return _DoubleSize(std::get<double>(value_));
+		case ItemType::STRING:
+			return _JSONRawSize(asString());
+		case ItemType::ARRAY:
+			return std::get<JSONArray*>(value_)->serializedSize();
+		case ItemType::OBJECT:
+			return std::get<JSONObject*>(value_)->serializedSize();
+	}
+	return 0;
+}
+
+// Views and raw numbers hold nothing; a nested container counts its node as well.
+CU::JSONMemoryUsage CU::JSONItem::memoryUsage() const
+{
+	JSONMemoryUsage usage{};
+	switch (type_) {
+		case ItemType::STRING:
+			if (const auto str = std::get_if<std::pmr::string>(std::addressof(value_))) {
+				_CountString(*str, usage.strings, usage.slack);
+			}
+			break;
+		case ItemType::ARRAY:
+			usage.nodes += sizeof(JSONArray);
+			usage += std::get<JSONArray*>(value_)->memoryUsage();
+			break;
+		case ItemType::OBJECT:
+			usage.nodes += sizeof(JSONObject);
+			usage += std::get<JSONObject*>(value_)->memoryUsage();
+			break;
+		default:
+			break;
+	}
+	return usage;
+}
+
+void CU::JSONItem::shrinkToFit()
+{
+	switch (type_) {
+		case ItemType::STRING:
+			if (const auto str = std::get_if<std::pmr::string>(std::addressof(value_))) {
+				str->shrink_to_fit();
+			}
+			break;
+		case ItemType::ARRAY:
+			std::get<JSONArray*>(value_)->shrinkToFit();
+			break;
+		case ItemType::OBJECT:
+			std::get<JSONObject*>(value_)->shrinkToFit();
+			break;
+		default:
+			break;
+	}
+}
+
+void CU::JSONItem::_Release() noexcept
+{
+	if (type_ == ItemType::ARRAY) {
+		_DeleteNode(std::get<JSONArray*>(value_));
+	} else if (type_ == ItemType::OBJECT) {
+		_DeleteNode(std::get<JSONObject*>(value_));
+	}
+	type_ = ItemType::ITEM_NULL;
+	value_ = ItemNull();
+}
+
+// A container value about to be dropped takes the caches above it along.
+void CU::JSONItem::_Notify() const noexcept
+{
+	if (type_ == ItemType::ARRAY) {
+		std::get<JSONArray*>(value_)->_Invalidate();
+	} else if (type_ == ItemType::OBJECT) {
+		std::get<JSONObject*>(value_)->_Invalidate();
+	}
+}
+
+// A container moved to another item no longer reports to its old parent, the new one adopts
+// it when it caches again. Items only move by relocation, which is not a write, or out of a
+// slot some accessor has handed out, which already dropped the caches above it.
+void CU::JSONItem::_Detach() const noexcept
+{
+	if (type_ == ItemType::ARRAY) {
+		std::get<JSONArray*>(value_)->parent_.store(nullptr, std::memory_order_relaxed);
+	} else if (type_ == ItemType::OBJECT) {
+		std::get<JSONObject*>(value_)->parent_.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+// Called while a caching container builds its text, so the containers inside cache theirs.
+void CU::JSONItem::_CacheText() const noexcept
+{
+	if (type_ == ItemType::ARRAY) {
+		std::get<JSONArray*>(value_)->cacheText_.store(true, std::memory_order_relaxed);
+	} else if (type_ == ItemType::OBJECT) {
+		std::get<JSONObject*>(value_)->cacheText_.store(true, std::memory_order_relaxed);
+	}
+}
+
 bool CU::JSONItem::toBoolean() const
 {
 	if (type_ == ItemType::BOOLEAN) {
@@ -262,6 +614,9 @@ bool CU::JSONItem::toBoolean() const
 int CU::JSONItem::toInt() const
 {
 	if (type_ == ItemType::INTEGER) {
+		if (const auto raw = std::get_if<_RawNumber>(std::addressof(value_))) {
+			return _RawValue<int>(*raw);
+		}
 		return std::get<int>(value_);
 	}
 	return {};
@@ -270,6 +625,9 @@ int CU::JSONItem::toInt() const
 int64_t CU::JSONItem::toLong() const
 {
 	if (type_ == ItemType::LONG) {
+		if (const auto raw = std::get_if<_RawNumber>(std::addressof(value_))) {
+			return _RawValue<int64_t>(*raw);
+		}
 		return std::get<int64_t>(value_);
 	}
 	return {};
@@ -278,6 +636,9 @@ int64_t CU::JSONItem::toLong() const
 double CU::JSONItem::toDouble() const
 {
 	if (type_ == ItemType::DOUBLE) {
+		if (const auto raw = std::get_if<_RawNumber>(std::addressof(value_))) {
+			return _RawValue<double>(*raw);
+		}
 		return std::get<double>(value_);
 	}
 	return {};
@@ -286,7 +647,7 @@ double CU::JSONItem::toDouble() const
 std::string CU::JSONItem::toString() const
 {
 	if (type_ == ItemType::STRING) {
-		return std::get<std::string>(value_);
+		return std::string(asString());
 	}
 	return {};
 }
@@ -309,6 +670,9 @@ CU::JSONObject CU::JSONItem::toObject() const
 
 std::string CU::JSONItem::toRaw() const
 {
+	if (const auto raw = std::get_if<_RawNumber>(std::addressof(value_))) {
+		return std::string(raw->view());
+	}
 	std::string JSONRaw{};
 	switch (type_) {
 		case ItemType::ITEM_NULL:
@@ -331,7 +695,7 @@ std::string CU::JSONItem::toRaw() const
 			JSONRaw = std::to_string(std::get<double>(value_));
 			break;
 		case ItemType::STRING:
-			JSONRaw = _StringToJSONRaw(std::get<std::string>(value_));
+			JSONRaw = _StringToJSONRaw(asString());
 			break;
 		case ItemType::ARRAY:
 			JSONRaw = std::get<JSONArray*>(value_)->toString();
@@ -343,220 +707,174 @@ std::string CU::JSONItem::toRaw() const
 	return JSONRaw;
 }
 
-CU::JSONArray::JSONArray() : data_() { }
-
-CU::JSONArray::JSONArray(const size_t &init_size) : data_(init_size) { }
-
-CU::JSONArray::JSONArray(const size_t &init_size, const JSONItem &init_value) : data_(init_size, init_value) { }
-
-CU::JSONArray::JSONArray(Iterator begin_iter, Iterator end_iter) : data_(begin_iter, end_iter) { }
-
-CU::JSONArray::JSONArray(const std::string &JSONString) : data_()
-{
-	enum class ArrayIdx : uint8_t {NONE, ITEM_FRONT, ITEM_COMMON, ITEM_STRING, ITEM_ARRAY, ITEM_OBJECT, ITEM_BACK};
-	size_t pos = 0;
-	auto idx = ArrayIdx::NONE;
-	uint32_t count = 0;
-	std::string content{};
-	while (pos < JSONString.size()) {
-		const char &ch = JSONString.at(pos);
-		switch (ch) {
-			case '[':
-				if (idx == ArrayIdx::NONE) {
-					idx = ArrayIdx::ITEM_FRONT;
-				} else if (idx == ArrayIdx::ITEM_FRONT) {
-					idx = ArrayIdx::ITEM_ARRAY;
-					count = 1;
-					content += ch;
-				} else if (idx == ArrayIdx::ITEM_ARRAY) {
-					count++;
-					content += ch;
-				} else if (idx == ArrayIdx::ITEM_STRING || idx == ArrayIdx::ITEM_OBJECT) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
-			case ']':
-				if (idx == ArrayIdx::ITEM_BACK || idx == ArrayIdx::ITEM_COMMON) {
-					idx = ArrayIdx::NONE;
-				} else if (idx == ArrayIdx::ITEM_FRONT && data_.empty()) {
-					idx = ArrayIdx::NONE;
-				} else if (idx == ArrayIdx::ITEM_ARRAY) {
-					if (count > 0) {
-						count--;
-						content += ch;
-						if (count == 0) {
-							idx = ArrayIdx::ITEM_BACK;
-						}
-					} else {
-						throw JSONExcept("Invalid JSONArray Structure");
-					}
-				} else if (idx == ArrayIdx::ITEM_STRING || idx == ArrayIdx::ITEM_OBJECT) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
-			case ',':
-				if (idx == ArrayIdx::ITEM_BACK || idx == ArrayIdx::ITEM_COMMON) {
-					idx = ArrayIdx::ITEM_FRONT;
-				} else if (idx == ArrayIdx::ITEM_STRING || idx == ArrayIdx::ITEM_ARRAY || idx == ArrayIdx::ITEM_OBJECT) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
-			case '{':
-				if (idx == ArrayIdx::ITEM_FRONT) {
-					idx = ArrayIdx::ITEM_OBJECT;
-					count = 1;
-					content += ch;
-				} else if (idx == ArrayIdx::ITEM_OBJECT) {
-					count++;
-					content += ch;
-				} else if (idx == ArrayIdx::ITEM_STRING || idx == ArrayIdx::ITEM_ARRAY) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
-			case '}':
-				if (idx == ArrayIdx::ITEM_OBJECT) {
-					if (count > 0) {
-						count--;
-						content += ch;
-						if (count == 0) {
-							idx = ArrayIdx::ITEM_BACK;
-						}
-					} else {
-						throw JSONExcept("Invalid JSONArray Structure");
-					}
-				} else if (idx == ArrayIdx::ITEM_STRING || idx == ArrayIdx::ITEM_ARRAY) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
-			case '\"':
-				if (idx == ArrayIdx::ITEM_FRONT) {
-					idx = ArrayIdx::ITEM_STRING;
-					content += ch;
-				} else if (idx == ArrayIdx::ITEM_STRING) {
-					idx = ArrayIdx::ITEM_BACK;
-					content += ch;
-				} else if (idx == ArrayIdx::ITEM_ARRAY || idx == ArrayIdx::ITEM_OBJECT) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
-			case ' ':
-				if (idx == ArrayIdx::ITEM_STRING || idx == ArrayIdx::ITEM_ARRAY || idx == ArrayIdx::ITEM_OBJECT) {
-					content += ch;
-				}
-				break;
-			case '\n':
-			case '\t':
-			case '\r':
-			case '\f':
-			case '\a':
-			case '\b':
-			case '\v':
-				break;
-			case '\\':
-				if (idx == ArrayIdx::ITEM_STRING) {
-					pos++;
-					content += _GetEscapeChar(JSONString.at(pos));
-				} else if (idx == ArrayIdx::ITEM_ARRAY || idx == ArrayIdx::ITEM_OBJECT) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
-				break;
+CU::JSONArray &CU::JSONItem::asArray()
+{
+	if (type_ != ItemType::ARRAY) {
+		throw JSONExcept("Item is not a JSONArray");
+	}
+	return *std::get<JSONArray*>(value_);
+}
+
+CU::JSONObject &CU::JSONItem::asObject()
+{
+	if (type_ != ItemType::OBJECT) {
+		throw JSONExcept("Item is not a JSONObject");
+	}
+	return *std::get<JSONObject*>(value_);
+}
+
+const CU::JSONArray &CU::JSONItem::asArray() const
+{
+	if (type_ != ItemType::ARRAY) {
+		throw JSONExcept("Item is not a JSONArray");
+	}
+	return *(std::get<JSONArray*>(value_));
+}
+
+const CU::JSONObject &CU::JSONItem::asObject() const
+{
+	if (type_ != ItemType::OBJECT) {
+		throw JSONExcept("Item is not a JSONObject");
+	}
+	return *(std::get<JSONObject*>(value_));
+}
+
+std::string_view CU::JSONItem::asString() const
+{
+	if (type_ != ItemType::STRING) {
+		throw JSONExcept("Item is not a string");
+	}
+	if (const auto view = std::get_if<std::string_view>(std::addressof(value_))) {
+		return *view;
+	}
+	return std::get<std::pmr::string>(value_);
+}
+
+void CU::JSONItem::_CopyValue(const JSONItem &other)
+{
+	switch (other.type_) {
+		case ItemType::STRING:
+			{
+				// Copies own their text, also when the other item is a view.
+				const auto str = other.asString();
+				value_ = std::pmr::string(str.data(), str.size(), GetMemoryResource());
+			}
+			break;
+		case ItemType::ARRAY:
+			value_ = _NewNode<JSONArray>(*(std::get<JSONArray*>(other.value_)));
+			break;
+		case ItemType::OBJECT:
+			value_ = _NewNode<JSONObject>(*(std::get<JSONObject*>(other.value_)));
+			break;
+		default:
+			value_ = other.value_;
+			break;
+	}
+	type_ = other.type_;
+}
+
+// The value as the eager, copying parser would have stored it.
+CU::ItemValue CU::JSONItem::_Value() const
+{
+	if (std::holds_alternative<_RawNumber>(value_)) {
+		switch (type_) {
+			case ItemType::INTEGER:
+				return toInt();
+			case ItemType::LONG:
+				return toLong();
 			default:
-				if (idx == ArrayIdx::ITEM_FRONT) {
-					idx = ArrayIdx::ITEM_COMMON;
-					content += ch;
-				} else if (idx != ArrayIdx::NONE && idx != ArrayIdx::ITEM_BACK) {
-					content += ch;
-				} else {
-					throw JSONExcept("Invalid JSONArray Structure");
-				}
 				break;
 		}
-		if ((idx == ArrayIdx::ITEM_FRONT || idx == ArrayIdx::NONE) && !content.empty()) {
-			data_.emplace_back(JSONItem::_To_Init_Val(content));
-			content.clear();
-		}
-		pos++;
-	}
-	if (idx != ArrayIdx::NONE) {
-		throw JSONExcept("Invalid JSONArray Structure");
+		return toDouble();
+	} else if (const auto view = std::get_if<std::string_view>(std::addressof(value_))) {
+		return std::pmr::string(view->data(), view->size(), GetMemoryResource());
 	}
+	return std::visit([](const auto &value) -> ItemValue {
+		if constexpr (std::is_same_v<std::decay_t<decltype(value)>, _RawNumber> || std::is_same_v<std::decay_t<decltype(value)>, std::string_view>) {
+			return ItemNull();
+		} else {
+			return value;
+		}
+	}, value_);
 }
 
-CU::JSONArray::JSONArray(const std::vector<JSONItem> &data) : data_(data) { }
+CU::JSONArray::JSONArray() : data_(GetMemoryResource()) { }
 
-CU::JSONArray::JSONArray(const std::vector<bool> &list) : data_() { 
+CU::JSONArray::JSONArray(const size_t &init_size) : data_(init_size, std::pmr::polymorphic_allocator<JSONItem>(GetMemoryResource())) { }
+
+CU::JSONArray::JSONArray(const size_t &init_size, const JSONItem &init_value) : data_(init_size, init_value, GetMemoryResource()) { }
+
+CU::JSONArray::JSONArray(Iterator begin_iter, Iterator end_iter) : data_(begin_iter, end_iter, GetMemoryResource()) { }
+
+CU::JSONArray::JSONArray(const std::string &JSONString) : data_(GetMemoryResource())
+{
+	_ThreadParser().parse(JSONString, *this);
+}
+
+CU::JSONArray::JSONArray(const std::vector<JSONItem> &data) : data_(data.begin(), data.end(), GetMemoryResource()) { }
+
+CU::JSONArray::JSONArray(const std::vector<bool> &list) : data_(GetMemoryResource())
+{
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const std::vector<int> &list) : data_()
+CU::JSONArray::JSONArray(const std::vector<int> &list) : data_(GetMemoryResource())
 {
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const std::vector<int64_t> &list) : data_()
+CU::JSONArray::JSONArray(const std::vector<int64_t> &list) : data_(GetMemoryResource())
 {
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const std::vector<double> &list) : data_()
+CU::JSONArray::JSONArray(const std::vector<double> &list) : data_(GetMemoryResource())
 {
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const std::vector<std::string> &list) : data_()
+CU::JSONArray::JSONArray(const std::vector<std::string> &list) : data_(GetMemoryResource())
 {
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const std::vector<JSONArray> &list) : data_()
+CU::JSONArray::JSONArray(const std::vector<JSONArray> &list) : data_(GetMemoryResource())
 {
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const std::vector<JSONObject> &list) : data_()
+CU::JSONArray::JSONArray(const std::vector<JSONObject> &list) : data_(GetMemoryResource())
 {
 	for (auto iter = list.begin(); iter < list.end(); iter++) {
 		data_.emplace_back(*iter);
 	}
 }
 
-CU::JSONArray::JSONArray(const JSONArray &other) : data_()
+CU::JSONArray::JSONArray(const JSONArray &other) : data_(GetMemoryResource())
 {
 	if (std::addressof(other) != this) {
-		data_ = other.data();
+		data_ = other.data_;
 	}
 }
 
-CU::JSONArray::JSONArray(JSONArray &&other) noexcept : data_()
+// The containers among the items may still name other as their parent, so they are adopted right away.
+CU::JSONArray::JSONArray(JSONArray &&other) noexcept : data_(std::move(other.data_), GetMemoryResource())
 {
-	if (std::addressof(other) != this) {
-		data_ = other.data();
+	_TakeCache(other);
+	for (const auto &item : data_) {
+		_Adopt(item);
 	}
 }
 
@@ -565,7 +883,8 @@ CU::JSONArray::~JSONArray() { }
 CU::JSONArray &CU::JSONArray::operator()(const JSONArray &other)
 {
 	if (std::addressof(other) != this) {
-		data_ = other.data();
+		_Invalidate();
+		data_ = other.data_;
 	}
 	return *this;
 }
@@ -573,50 +892,68 @@ CU::JSONArray &CU::JSONArray::operator()(const JSONArray &other)
 CU::JSONArray &CU::JSONArray::operator=(const JSONArray &other)
 {
 	if (std::addressof(other) != this) {
-		data_ = other.data();
+		_Invalidate();
+		data_ = other.data_;
 	}
 	return *this;
 }
 
 CU::JSONArray &CU::JSONArray::operator+=(const JSONArray &other)
 {
+	_Invalidate();
 	if (std::addressof(other) != this) {
-		const auto &other_data = other.data();
-		for (auto iter = other_data.begin(); iter < other_data.end(); iter++) {
-			data_.emplace_back(*iter);
-		}
+		data_.insert(data_.end(), other.data_.begin(), other.data_.end());
 	}
 	return *this;
 }
 
 CU::JSONItem &CU::JSONArray::operator[](const size_t &pos)
 {
+	_Invalidate();
 	if (pos >= data_.size()) {
 		data_.resize(pos + 1);
 	}
 	return data_.at(pos);
 }
 
-CU::JSONArray CU::JSONArray::operator+(const JSONArray &other) const
+CU::JSONItem* CU::JSONArray::lookup(const size_t &pos)
 {
-	auto merged_data = data_;
-	if (std::addressof(other) != this) {
-		const auto &other_data = other.data();
-		for (auto iter = other_data.begin(); iter < other_data.end(); iter++) {
-			merged_data.emplace_back(*iter);
-		}
+	_Invalidate();
+	if (pos >= data_.size()) {
+		return nullptr;
+	}
+	return std::addressof(data_[pos]);
+}
+
+const CU::JSONItem* CU::JSONArray::lookup(const size_t &pos) const
+{
+	if (pos >= data_.size()) {
+		return nullptr;
 	}
-	return JSONArray(merged_data);
+	return std::addressof(data_[pos]);
+}
+
+CU::JSONArray CU::JSONArray::operator+(const JSONArray &other) const
+{
+	JSONArray merged_array(*this);
+	merged_array.data_.insert(merged_array.data_.end(), other.data_.begin(), other.data_.end());
+	return merged_array;
 }
 
 bool CU::JSONArray::operator==(const JSONArray &other) const
 {
-	return (data_ == other.data());
+	if (std::addressof(other) == this) {
+		return true;
+	}
+	if (data_.size() != other.data_.size() || hash() != other.hash()) {
+		return false;
+	}
+	return (data_ == other.data_);
 }
 
 bool CU::JSONArray::operator!=(const JSONArray &other) const
 {
-	return (data_ != other.data());
+	return !(*this == other);
 }
 
 std::vector<bool> CU::JSONArray::toListBoolean() const
@@ -692,6 +1029,7 @@ CU::JSONItem CU::JSONArray::at(const size_t &pos) const
 
 CU::JSONArray::Iterator CU::JSONArray::find(const JSONItem &item)
 {
+	_Invalidate();
 	if (data_.begin() == data_.end()) {
 		return data_.end();
 	}
@@ -700,11 +1038,13 @@ CU::JSONArray::Iterator CU::JSONArray::find(const JSONItem &item)
 
 void CU::JSONArray::add(const JSONItem &item)
 {
+	_Invalidate();
 	data_.emplace_back(item);
 }
 
 void CU::JSONArray::remove(const JSONItem &item)
 {
+	_Invalidate();
 	auto iter = std::find(data_.begin(), data_.end(), item);
 	if (iter == data_.end()) {
 		throw JSONExcept("Item not found");
@@ -712,13 +1052,33 @@ void CU::JSONArray::remove(const JSONItem &item)
 	data_.erase(iter);
 }
 
+void CU::JSONArray::insert(const size_t &pos, const JSONItem &item)
+{
+	_Invalidate();
+	if (pos > data_.size()) {
+		throw JSONExcept("Position out of bound");
+	}
+	data_.emplace(data_.begin() + pos, item);
+}
+
+void CU::JSONArray::erase(const size_t &pos)
+{
+	_Invalidate();
+	if (pos >= data_.size()) {
+		throw JSONExcept("Position out of bound");
+	}
+	data_.erase(data_.begin() + pos);
+}
+
 void CU::JSONArray::resize(const size_t &new_size)
 {
+	_Invalidate();
 	data_.resize(new_size);
 }
 
 void CU::JSONArray::clear()
 {
+	_Invalidate();
 	data_.clear();
 }
 
@@ -734,43 +1094,136 @@ bool CU::JSONArray::empty() const
 
 std::vector<CU::JSONItem> CU::JSONArray::data() const
 {
-	return data_;
+	return std::vector<JSONItem>(data_.begin(), data_.end());
 }
 
 std::string CU::JSONArray::toString() const
 {
-	if (data_.begin() == data_.end()) {
-		std::string JSONText("[]");
-		return JSONText;
-	} else if ((data_.begin() + 1) == data_.end()) {
-		auto JSONText = std::string("[") + data_.front().toRaw() + "]";
-		return JSONText;
+	_CU_STATS_PHASE(SERIALIZE, 0);
+	std::string JSONText{};
+	JSONText.reserve(serializedSize());
+	_WriteRaw(*this, JSONText);
+	_CU_STATS_OUTPUT(JSONText.size());
+	return JSONText;
+}
+
+std::pmr::memory_resource* CU::JSONArray::resource() const
+{
+	return data_.get_allocator().resource();
+}
+
+size_t CU::JSONArray::hash() const
+{
+	auto hash = hash_.load(std::memory_order_relaxed);
+	if (hash == 0) {
+		uint64_t value = _HashMix(_HashSeed ^ data_.size());
+		for (const auto &item : data_) {
+			_Adopt(item);
+			value = _HashCombine(value, item.hash());
+		}
+		hash = _HashValue(value);
+		hash_.store(hash, std::memory_order_relaxed);
+	}
+	return hash;
+}
+
+size_t CU::JSONArray::serializedSize() const
+{
+	auto size = textSize_.load(std::memory_order_relaxed);
+	if (size == 0) {
+		size = data_.empty() ? 2 : data_.size() + 1;
+		for (const auto &item : data_) {
+			_Adopt(item);
+			size += item.serializedSize();
+		}
+		textSize_.store(size, std::memory_order_relaxed);
 	}
-	std::string JSONText("[");
-	for (auto iter = data_.begin(); iter < (data_.end() - 1); iter++) {
-		JSONText += iter->toRaw() + ",";
+	return size;
+}
+
+CU::JSONMemoryUsage CU::JSONArray::memoryUsage() const
+{
+	JSONMemoryUsage usage{};
+	usage.nodes = data_.size() * sizeof(JSONItem);
+	usage.slack = (data_.capacity() - data_.size()) * sizeof(JSONItem);
+	for (const auto &item : data_) {
+		usage += item.memoryUsage();
 	}
-	JSONText += data_.back().toRaw() + "]";
-	return JSONText;
+	return usage;
+}
+
+// The content is unchanged and the caches stay valid, but the containers among the items
+// are detached by the move and have to be adopted again.
+void CU::JSONArray::shrinkToFit()
+{
+	data_.shrink_to_fit();
+	for (const auto &item : data_) {
+		_Adopt(item);
+	}
+	for (auto &item : data_) {
+		item.shrinkToFit();
+	}
+}
+
+void CU::JSONArray::cacheText(const bool &enable)
+{
+	cacheText_.store(enable, std::memory_order_relaxed);
+	if (!enable) {
+		_Invalidate();
+		for (auto &item : data_) {
+			if (item.type() == ItemType::ARRAY) {
+				item.asArray().cacheText(false);
+			} else if (item.type() == ItemType::OBJECT) {
+				item.asObject().cacheText(false);
+			}
+		}
+	}
+}
+
+// Concurrent readers may each build the text, the first one to publish it wins.
+const std::string &CU::JSONArray::_Text() const
+{
+	auto text = text_.load(std::memory_order_acquire);
+	if (text == nullptr) {
+		auto built = std::make_unique<std::string>();
+		built->reserve(serializedSize());
+		*built += '[';
+		for (auto iter = data_.begin(); iter != data_.end(); iter++) {
+			if (iter != data_.begin()) {
+				*built += ',';
+			}
+			iter->_CacheText();
+			_WriteRaw(*iter, *built);
+		}
+		*built += ']';
+		if (text_.compare_exchange_strong(text, built.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+			text = built.release();
+		}
+	}
+	return *text;
 }
 
 CU::JSONItem &CU::JSONArray::front()
 {
+	_Invalidate();
 	return data_.front();
 }
 
 CU::JSONItem &CU::JSONArray::back()
 {
+	_Invalidate();
 	return data_.back();
 }
 
 CU::JSONArray::Iterator CU::JSONArray::begin()
 {
+	_Invalidate();
 	return data_.begin();
 }
 
 CU::JSONArray::Iterator CU::JSONArray::end()
 {
+	_Invalidate();
 	return data_.end();
 }
 
@@ -784,208 +1237,61 @@ CU::JSONArray::ConstIterator CU::JSONArray::end() const
 	return data_.end();
 }
 
-CU::JSONObject::JSONObject() : data_(), order_() { }
-
-CU::JSONObject::JSONObject(const std::string &JSONString) : data_(), order_() 
-{
-	enum class ObjectIdx : uint8_t 
-	{NONE, KEY_FRONT, KEY_CONTENT, KEY_BACK, VALUE_FRONT, VALUE_COMMON, VALUE_STRING, VALUE_ARRAY, VALUE_OBJECT, VALUE_BACK};
-	size_t pos = 0;
-	auto idx = ObjectIdx::NONE;
-	uint32_t count = 0;
-	std::string key{}, value{};
-	while (pos < JSONString.size()) {
-		const auto &ch = JSONString.at(pos);
-		switch (ch) {
-			case '{':
-				if (idx == ObjectIdx::NONE) {
-					idx = ObjectIdx::KEY_FRONT;
-				} else if (idx == ObjectIdx::VALUE_FRONT) {
-					idx = ObjectIdx::VALUE_OBJECT;
-					count = 1;
-					value += ch;
-				} else if (idx == ObjectIdx::VALUE_OBJECT) {
-					count++;
-					value += ch;
-				} else if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_ARRAY) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case '}':
-				if (idx == ObjectIdx::KEY_FRONT && data_.empty()) {
-					idx = ObjectIdx::NONE;
-				} else if (idx == ObjectIdx::VALUE_OBJECT) {
-					if (count > 0) {
-						count--;
-						value += ch;
-						if (count == 0) {
-							idx = ObjectIdx::VALUE_BACK;
-						}
-					} else {
-						throw JSONExcept("Invalid JSONObject Structure");
-					}
-				} else if (idx == ObjectIdx::VALUE_BACK || idx == ObjectIdx::VALUE_COMMON) {
-					idx = ObjectIdx::NONE;
-				} else if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_ARRAY) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case '\"':
-				if (idx == ObjectIdx::KEY_FRONT) {
-					idx = ObjectIdx::KEY_CONTENT;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					idx = ObjectIdx::KEY_BACK;
-				} else if (idx == ObjectIdx::VALUE_FRONT) {
-					idx = ObjectIdx::VALUE_STRING;
-					value += ch;
-				} else if (idx == ObjectIdx::VALUE_STRING) {
-					idx = ObjectIdx::VALUE_BACK;
-					value += ch;
-				} else if (idx == ObjectIdx::VALUE_ARRAY || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case ':':
-				if (idx == ObjectIdx::KEY_BACK) {
-					idx = ObjectIdx::VALUE_FRONT;
-				} else if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_ARRAY || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case ',':
-				if (idx == ObjectIdx::VALUE_COMMON || idx == ObjectIdx::VALUE_BACK) {
-					idx = ObjectIdx::KEY_FRONT;
-				} else if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_ARRAY || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case '[':
-				if (idx == ObjectIdx::VALUE_FRONT) {
-					idx = ObjectIdx::VALUE_ARRAY;
-					count = 1;
-					value += ch;
-				} else if (idx == ObjectIdx::VALUE_ARRAY) {
-					count++;
-					value += ch;
-				} else if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case ']':
-				if (idx == ObjectIdx::VALUE_ARRAY) {
-					if (count > 0) {
-						count--;
-						value += ch;
-						if (count == 0) {
-							idx = ObjectIdx::VALUE_BACK;
-						}
-					} else {
-						throw JSONExcept("Invalid JSONObject Structure");
-					}
-				} else if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			case ' ':
-				if (idx == ObjectIdx::VALUE_STRING || idx == ObjectIdx::VALUE_ARRAY || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				}
-				break;
-			case '\n':
-			case '\t':
-			case '\r':
-			case '\f':
-			case '\a':
-			case '\b':
-			case '\v':
-				break;
-			case '\\':
-				if (idx == ObjectIdx::KEY_CONTENT) {
-					pos++;
-					key += _GetEscapeChar(JSONString.at(pos));
-				} else if (idx == ObjectIdx::VALUE_STRING) {
-					pos++;
-					value += _GetEscapeChar(JSONString.at(pos));
-				} else if (idx == ObjectIdx::VALUE_ARRAY || idx == ObjectIdx::VALUE_OBJECT) {
-					value += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-			default:
-				if (idx == ObjectIdx::VALUE_FRONT) {
-					idx = ObjectIdx::VALUE_COMMON;
-					value += ch;
-				} else if (idx == ObjectIdx::KEY_CONTENT) {
-					key += ch;
-				} else if (idx == ObjectIdx::VALUE_COMMON || idx == ObjectIdx::VALUE_STRING ||
-					idx == ObjectIdx::VALUE_ARRAY || idx == ObjectIdx::VALUE_OBJECT
-				) {
-					value += ch;
-				} else {
-					throw JSONExcept("Invalid JSONObject Structure");
-				}
-				break;
-		}
-		if ((idx == ObjectIdx::KEY_FRONT || idx == ObjectIdx::NONE) && !key.empty() && !value.empty()) {
-			order_.emplace_back(key);
-			data_.emplace(key, JSONItem::_To_Init_Val(value));
-			key.clear();
-			value.clear();
+CU::JSONObject::JSONObject() : data_(GetMemoryResource()), order_(GetMemoryResource()) { }
+
+CU::JSONObject::JSONObject(const std::string &JSONString) : data_(GetMemoryResource()), order_(GetMemoryResource())
+{
+	_ThreadParser().parse(JSONString, *this);
+}
+
+CU::JSONObject::JSONObject(const std::unordered_map<std::string, JSONItem> &data, const std::vector<std::string> &order) : 
+	data_(GetMemoryResource()),
+	order_(GetMemoryResource())
+{
+	// Members listed in order come first, the ones missing from it follow in map order.
+	data_.reserve(data.size());
+	order_.reserve(data.size());
+	for (const auto &key : order) {
+		auto iter = data.find(key);
+		if (iter != data.end()) {
+			auto result = data_.try_emplace(_ToKey(key), iter->second);
+			if (result.second) {
+				order_.emplace_back(std::addressof(*result.first));
+			}
 		}
-		pos++;
 	}
-	if (idx != ObjectIdx::NONE) {
-		throw JSONExcept("Invalid JSONObject Structure");
+	for (const auto &[key, value] : data) {
+		auto result = data_.try_emplace(_ToKey(key), value);
+		if (result.second) {
+			order_.emplace_back(std::addressof(*result.first));
+		}
 	}
 }
 
-CU::JSONObject::JSONObject(const std::unordered_map<std::string, JSONItem> &data, const std::vector<std::string> &order) : 
-	data_(data),
-	order_(order)
-{ }
-
-CU::JSONObject::JSONObject(const JSONObject &other) : data_(), order_()
+CU::JSONObject::JSONObject(const JSONObject &other) : data_(GetMemoryResource()), order_(GetMemoryResource())
 {
-	if (std::addressof(other) != this) {
-		data_ = other.data();
-		order_ = other.order();
-	}
+	_Assign(other);
 }
 
-CU::JSONObject::JSONObject(JSONObject &&other) noexcept : data_(), order_()
+// Nodes only change hands when both objects share a memory resource, otherwise the members
+// are moved one by one into nodes of this object's resource.
+CU::JSONObject::JSONObject(JSONObject &&other) noexcept : data_(GetMemoryResource()), order_(GetMemoryResource())
 {
-	if (std::addressof(other) != this) {
-		data_ = other.data();
-		order_ = other.order();
+	if (data_.get_allocator() == other.data_.get_allocator()) {
+		data_.swap(other.data_);
+		order_.swap(other.order_);
+	} else {
+		data_.reserve(other.order_.size());
+		order_.reserve(other.order_.size());
+		for (const auto &entry : other.order_) {
+			order_.emplace_back(std::addressof(*data_.emplace(entry->first, std::move(entry->second)).first));
+		}
+		other.data_.clear();
+		other.order_.clear();
+	}
+	_TakeCache(other);
+	for (const auto &entry : order_) {
+		_Adopt(entry->second);
 	}
 }
 
@@ -993,33 +1299,26 @@ CU::JSONObject::~JSONObject() { }
 
 CU::JSONObject &CU::JSONObject::operator()(const JSONObject &other)
 {
-	if (std::addressof(other) != this) {
-		data_ = other.data();
-		order_ = other.order();
-	}
+	_Assign(other);
 	return *this;
 }
 
 CU::JSONObject &CU::JSONObject::operator=(const JSONObject &other)
 {
-	if (std::addressof(other) != this) {
-		data_ = other.data();
-		order_ = other.order();
-	}
+	_Assign(other);
 	return *this;
 }
 
 CU::JSONObject &CU::JSONObject::operator+=(const JSONObject &other)
 {
+	_Invalidate();
 	if (std::addressof(other) != this) {
-		auto other_data = other.data();
-		auto other_order = other.order();
-		for (const auto &key : other_order) {
-			if (data_.count(key) == 0) {
-				order_.emplace_back(key);
-				data_.emplace(key, other_data.at(key));
+		for (const auto &[key, value] : other) {
+			auto result = data_.try_emplace(key, value);
+			if (result.second) {
+				order_.emplace_back(std::addressof(*result.first));
 			} else {
-				data_[key] = other_data.at(key);
+				result.first->second = value;
 			}
 		}
 	}
@@ -1028,75 +1327,103 @@ CU::JSONObject &CU::JSONObject::operator+=(const JSONObject &other)
 
 CU::JSONItem &CU::JSONObject::operator[](const std::string &key)
 {
-	if (data_.count(key) == 0) {
-		order_.emplace_back(key);
+	_Invalidate();
+	auto iter = data_.find(_ProbeKey(key));
+	if (iter == data_.end()) {
+		iter = data_.emplace(_ToKey(key), JSONItem()).first;
+		order_.emplace_back(std::addressof(*iter));
 	}
-	return data_[key];
+	return iter->second;
 }
 
 CU::JSONObject CU::JSONObject::operator+(const JSONObject &other) const
 {
-	auto merged_data = data_;
-	auto merged_order = order_;
-	const auto &other_data = other.data();
-	const auto &other_order = other.order();
-	for (const auto &key : other_order) {
-		if (merged_data.count(key) == 1) {
-			merged_data[key] = other_data.at(key);
-		} else {
-			merged_order.emplace_back(key);
-			merged_data.emplace(key, other_data.at(key));
-		}
-	}
-	return JSONObject(merged_data, merged_order);
+	JSONObject merged_object(*this);
+	merged_object += other;
+	return merged_object;
 }
 
+// Members are compared in order, as toString() would write them.
 bool CU::JSONObject::operator==(const JSONObject &other) const
 {
-	return (data_ == other.data() && order_ == other.order());
+	if (std::addressof(other) == this) {
+		return true;
+	}
+	if (order_.size() != other.order_.size() || hash() != other.hash()) {
+		return false;
+	}
+	for (size_t pos = 0; pos < order_.size(); pos++) {
+		if (order_[pos]->first != other.order_[pos]->first || order_[pos]->second != other.order_[pos]->second) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool CU::JSONObject::operator!=(const JSONObject &other) const
 {
-	return (data_ != other.data() || order_ != other.order());
+	return !(*this == other);
 }
 
 bool CU::JSONObject::contains(const std::string &key) const
 {
-	return (data_.count(key) == 1);
+	return (data_.count(_ProbeKey(key)) == 1);
 }
 
 CU::JSONItem CU::JSONObject::at(const std::string &key) const
 {
-	auto iter = data_.find(key);
+	auto iter = data_.find(_ProbeKey(key));
 	if (iter == data_.end()) {
 		throw JSONExcept("Key not found");
 	}
 	return iter->second;
 }
 
+CU::JSONItem* CU::JSONObject::lookup(const std::string_view &key)
+{
+	_Invalidate();
+	auto iter = data_.find(_ProbeKey(key));
+	if (iter == data_.end()) {
+		return nullptr;
+	}
+	return std::addressof(iter->second);
+}
+
+const CU::JSONItem* CU::JSONObject::lookup(const std::string_view &key) const
+{
+	auto iter = data_.find(_ProbeKey(key));
+	if (iter == data_.end()) {
+		return nullptr;
+	}
+	return std::addressof(iter->second);
+}
+
 void CU::JSONObject::add(const std::string &key, const JSONItem &value)
 {
-	if (data_.count(key) == 0) {
-		order_.emplace_back(key);
-		data_.emplace(key, value);
+	_Invalidate();
+	auto iter = data_.find(_ProbeKey(key));
+	if (iter == data_.end()) {
+		iter = data_.emplace(_ToKey(key), value).first;
+		order_.emplace_back(std::addressof(*iter));
 	} else {
-		data_[key] = value;
+		iter->second = value;
 	}
 }
 
 void CU::JSONObject::remove(const std::string &key)
 {
-	auto iter = std::find(order_.begin(), order_.end(), key);
-	if (iter == order_.end()) {
+	_Invalidate();
+	auto iter = data_.find(_ProbeKey(key));
+	if (iter == data_.end()) {
 		throw JSONExcept("Key not found");
 	}
-	data_.erase(key);
-	order_.erase(iter);
+	order_.erase(std::find(order_.begin(), order_.end(), std::addressof(*iter)));
+	data_.erase(iter);
 }
 
 void CU::JSONObject::clear()
 {
+	_Invalidate();
 	data_.clear();
 	order_.clear();
 }
@@ -1113,60 +1440,286 @@ bool CU::JSONObject::empty() const
 
 std::unordered_map<std::string, CU::JSONItem> CU::JSONObject::data() const
 {
-	return data_;
+	std::unordered_map<std::string, JSONItem> data{};
+	data.reserve(data_.size());
+	for (const auto &[key, value] : data_) {
+		data.emplace(std::string(key.data(), key.size()), value);
+	}
+	return data;
 }
 
 std::vector<std::string> CU::JSONObject::order() const
 {
-	return order_;
+	std::vector<std::string> order{};
+	order.reserve(order_.size());
+	for (const auto &entry : order_) {
+		order.emplace_back(entry->first.data(), entry->first.size());
+	}
+	return order;
+}
+
+CU::JSONObject::Iterator CU::JSONObject::begin()
+{
+	_Invalidate();
+	return Iterator(order_.data());
+}
+
+CU::JSONObject::Iterator CU::JSONObject::end()
+{
+	_Invalidate();
+	return Iterator(order_.data() + order_.size());
+}
+
+CU::JSONObject::ConstIterator CU::JSONObject::begin() const
+{
+	return ConstIterator(order_.data());
+}
+
+CU::JSONObject::ConstIterator CU::JSONObject::end() const
+{
+	return ConstIterator(order_.data() + order_.size());
 }
 
 std::string CU::JSONObject::toString() const
 {
-	if (order_.begin() == order_.end()) {
-		std::string JSONString("{}");
-		return JSONString;
-	} else if ((order_.begin() + 1) == order_.end()) {
-		std::string JSONString("{");
-		JSONString += _StringToJSONRaw(order_.front()) + ":" + data_.at(order_.front()).toRaw() + "}";
-		return JSONString;
-	}
-	std::string JSONString("{");
-	for (auto iter = order_.begin(); iter < (order_.end() - 1); iter++) {
-		const auto &key = *iter;
-		JSONString += _StringToJSONRaw(key) + ":" + data_.at(key).toRaw() + ",";
-	}
-	JSONString += _StringToJSONRaw(order_.back()) + ":" + data_.at(order_.back()).toRaw() + "}";
+	_CU_STATS_PHASE(SERIALIZE, 0);
+	std::string JSONString{};
+	JSONString.reserve(serializedSize());
+	_WriteRaw(*this, JSONString);
+	_CU_STATS_OUTPUT(JSONString.size());
 	return JSONString;
 }
 
 std::string CU::JSONObject::toFormatedString() const
 {
+	_CU_STATS_PHASE(SERIALIZE, 0);
 	if (order_.begin() == order_.end()) {
 		std::string JSONString("{ }");
+		_CU_STATS_OUTPUT(JSONString.size());
 		return JSONString;
 	} else if ((order_.begin() + 1) == order_.end()) {
 		std::string JSONString("{\n");
-		JSONString += std::string("  ") + _StringToJSONRaw(order_.front()) + ": " + data_.at(order_.front()).toRaw() + "\n}";
+		JSONString += std::string("  ") + _StringToJSONRaw(order_.front()->first) + ": " + order_.front()->second.toRaw() + "\n}";
+		_CU_STATS_OUTPUT(JSONString.size());
 		return JSONString;
 	}
 	std::string JSONString("{\n");
 	for (auto iter = order_.begin(); iter < (order_.end() - 1); iter++) {
-		const auto &key = *iter;
-		JSONString += std::string("  ") + _StringToJSONRaw(key) + ": " + data_.at(key).toRaw() + ",\n";
+		const auto &[key, value] = **iter;
+		JSONString += std::string("  ") + _StringToJSONRaw(key) + ": " + value.toRaw() + ",\n";
 	}
-	JSONString += std::string("  ") + _StringToJSONRaw(order_.back()) + ": " + data_.at(order_.back()).toRaw() + "\n}";
+	JSONString += std::string("  ") + _StringToJSONRaw(order_.back()->first) + ": " + order_.back()->second.toRaw() + "\n}";
+	_CU_STATS_OUTPUT(JSONString.size());
 	return JSONString;
 }
 
+std::pmr::memory_resource* CU::JSONObject::resource() const
+{
+	return data_.get_allocator().resource();
+}
+
+size_t CU::JSONObject::hash() const
+{
+	auto hash = hash_.load(std::memory_order_relaxed);
+	if (hash == 0) {
+		uint64_t value = _HashMix(~_HashSeed ^ order_.size());
+		for (const auto &entry : order_) {
+			_Adopt(entry->second);
+			value = _HashCombine(value, _HashBytes(entry->first));
+			value = _HashCombine(value, entry->second.hash());
+		}
+		hash = _HashValue(value);
+		hash_.store(hash, std::memory_order_relaxed);
+	}
+	return hash;
+}
+
+size_t CU::JSONObject::serializedSize() const
+{
+	auto size = textSize_.load(std::memory_order_relaxed);
+	if (size == 0) {
+		size = order_.empty() ? 2 : order_.size() + 1;
+		for (const auto &entry : order_) {
+			_Adopt(entry->second);
+			size += _JSONRawSize(entry->first) + 1 + entry->second.serializedSize();
+		}
+		textSize_.store(size, std::memory_order_relaxed);
+	}
+	return size;
+}
+
+CU::JSONMemoryUsage CU::JSONObject::memoryUsage() const
+{
+	JSONMemoryUsage usage{};
+	usage.nodes = data_.size() * _MapNodeSize();
+	// A table of one bucket is kept inside the map.
+	usage.buckets = (data_.bucket_count() > 1) ? data_.bucket_count() * sizeof(void*) : 0;
+	for (const auto &[key, value] : data_) {
+		_CountString(key, usage.strings, usage.slack);
+		usage += value.memoryUsage();
+	}
+	usage.order += order_.size() * sizeof(Entry*);
+	usage.slack += (order_.capacity() - order_.size()) * sizeof(Entry*);
+	return usage;
+}
+
+// Keys of the map are const and allocated to size, only the values shrink.
+void CU::JSONObject::shrinkToFit()
+{
+	data_.rehash(0);
+	order_.shrink_to_fit();
+	for (auto &member : data_) {
+		member.second.shrinkToFit();
+	}
+}
+
+void CU::JSONObject::cacheText(const bool &enable)
+{
+	cacheText_.store(enable, std::memory_order_relaxed);
+	if (!enable) {
+		_Invalidate();
+		for (auto &member : data_) {
+			if (member.second.type() == ItemType::ARRAY) {
+				member.second.asArray().cacheText(false);
+			} else if (member.second.type() == ItemType::OBJECT) {
+				member.second.asObject().cacheText(false);
+			}
+		}
+	}
+}
+
+// The order list points into data_, so members are copied one by one rather than the map.
+void CU::JSONObject::_Assign(const JSONObject &other)
+{
+	if (std::addressof(other) == this) {
+		return;
+	}
+	// Built aside first, other may live inside one of the values being replaced.
+	decltype(data_) data(data_.get_allocator());
+	decltype(order_) order(order_.get_allocator());
+	data.reserve(other.order_.size());
+	order.reserve(other.order_.size());
+	for (const auto &[key, value] : other) {
+		order.emplace_back(std::addressof(*data.emplace(key, value).first));
+	}
+	_Invalidate();
+	data_.swap(data);
+	order_.swap(order);
+}
+
+// Concurrent readers may each build the text, the first one to publish it wins.
+const std::string &CU::JSONObject::_Text() const
+{
+	auto text = text_.load(std::memory_order_acquire);
+	if (text == nullptr) {
+		auto built = std::make_unique<std::string>();
+		built->reserve(serializedSize());
+		*built += '{';
+		for (auto iter = begin(); iter != end(); iter++) {
+			if (iter != begin()) {
+				*built += ',';
+			}
+			_AppendJSONRaw(*built, iter->first);
+			*built += ':';
+			iter->second._CacheText();
+			_WriteRaw(iter->second, *built);
+		}
+		*built += '}';
+		if (text_.compare_exchange_strong(text, built.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+			text = built.release();
+		}
+	}
+	return *text;
+}
+
 std::vector<CU::JSONObject::JSONPair> CU::JSONObject::toPairs() const
 {
 	std::vector<CU::JSONObject::JSONPair> pairs{};
-	for (const auto &key : order_) {
+	for (const auto &[key, value] : *this) {
 		JSONPair pair{};
-		pair.key = key;
-		pair.value = data_.at(key);
+		pair.key = std::string(key.data(), key.size());
+		pair.value = value;
 		pairs.emplace_back(pair);
 	}
 	return pairs;
 }
+
+void CU::_WriteRaw(const JSONItem &item, std::string &buffer)
+{
+	if (const auto raw = std::get_if<_RawNumber>(std::addressof(item.value_))) {
+		buffer.append(raw->text, raw->size);
+		return;
+	}
+	switch (item.type()) {
+		case ItemType::ITEM_NULL:
+			buffer += "null";
+			break;
+		case ItemType::BOOLEAN:
+			buffer += item.toBoolean() ? "true" : "false";
+			break;
+		case ItemType::INTEGER:
+			_AppendJSONInteger(buffer, item.toInt());
+			break;
+		case ItemType::LONG:
+			_AppendJSONInteger(buffer, item.toLong());
+			break;
+		case ItemType::DOUBLE:
+			_AppendJSONDouble(buffer, item.toDouble());
+			break;
+		case ItemType::STRING:
+			_AppendJSONRaw(buffer, item.asString());
+			break;
+		case ItemType::ARRAY:
+			_WriteRaw(item.asArray(), buffer);
+			break;
+		case ItemType::OBJECT:
+			_WriteRaw(item.asObject(), buffer);
+			break;
+	}
+}
+
+void CU::_WriteRaw(const JSONArray &array, std::string &buffer)
+{
+	if (array.cacheText_.load(std::memory_order_relaxed) && array.serializedSize() >= _MinCachedText) {
+		buffer += array._Text();
+		return;
+	}
+	buffer += '[';
+	for (auto iter = array.begin(); iter != array.end(); iter++) {
+		if (iter != array.begin()) {
+			buffer += ',';
+		}
+		_WriteRaw(*iter, buffer);
+	}
+	buffer += ']';
+}
+
+void CU::_WriteRaw(const JSONObject &object, std::string &buffer)
+{
+	if (object.cacheText_.load(std::memory_order_relaxed) && object.serializedSize() >= _MinCachedText) {
+		buffer += object._Text();
+		return;
+	}
+	buffer += '{';
+	for (auto iter = object.begin(); iter != object.end(); iter++) {
+		if (iter != object.begin()) {
+			buffer += ',';
+		}
+		_AppendJSONRaw(buffer, iter->first);
+		buffer += ':';
+		_WriteRaw(iter->second, buffer);
+	}
+	buffer += '}';
+}
+
+void CU::_AppendJSONInteger(std::string &buffer, const int64_t &value)
+{
+	char chars[24];
+	const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+	buffer.append(chars, result.ptr);
+}
+
+void CU::_AppendJSONDouble(std::string &buffer, const double &value)
+{
+	buffer += std::to_string(value);
+}
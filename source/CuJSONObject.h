@@ -7,18 +7,22 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <memory>
+#include <memory_resource>
+#include <atomic>
 #include <exception>
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <cstdlib>
 #include <cstdint>
 #include <climits>
 
 namespace CU
 {
-	inline char _GetEscapeChar(const char &ch) noexcept
+	constexpr char _GetEscapeChar(const char &ch) noexcept
 	{
 		switch (ch) {
 			case '\\':
@@ -49,50 +53,63 @@ namespace CU
 		return ch;
 	}
 
-	inline std::string _StringToJSONRaw(const std::string &str) 
+	// Appends the quoted and escaped string, copying the runs between escapes at once.
+	inline void _AppendJSONRaw(std::string &JSONRaw, const std::string_view &str)
 	{
-		std::string JSONRaw("\"");
-		for (const auto &ch : str) {
-			switch (ch) {
+		JSONRaw += '\"';
+		auto run = str.data();
+		const auto end = str.data() + str.size();
+		for (auto cur = run; cur != end; cur++) {
+			const char* escape = nullptr;
+			switch (*cur) {
 				case '\\':
-					JSONRaw += "\\\\";
+					escape = "\\\\";
 					break;
 				case '\"':
-					JSONRaw += "\\\"";
+					escape = "\\\"";
 					break;
 				case '\'':
-					JSONRaw += "\\\'";
+					escape = "\\\'";
 					break;
 				case '\n':
-					JSONRaw += "\\n";
+					escape = "\\n";
 					break;
 				case '\t':
-					JSONRaw += "\\t";
+					escape = "\\t";
 					break;
 				case '\r':
-					JSONRaw += "\\r";
+					escape = "\\r";
 					break;
 				case '\f':
-					JSONRaw += "\\f";
+					escape = "\\f";
 					break;
 				case '\a':
-					JSONRaw += "\\a";
+					escape = "\\a";
 					break;
 				case '\b':
-					JSONRaw += "\\b";
+					escape = "\\b";
 					break;
 				case '\v':
-					JSONRaw += "\\v";
+					escape = "\\v";
 					break;
 				case '/':
-					JSONRaw += "\\/";
+					escape = "\\/";
 					break;
 				default:
-					JSONRaw += ch;
-					break;
+					continue;
 			}
+			JSONRaw.append(run, cur);
+			JSONRaw.append(escape, 2);
+			run = cur + 1;
 		}
+		JSONRaw.append(run, end);
 		JSONRaw += '\"';
+	}
+
+	inline std::string _StringToJSONRaw(const std::string_view &str) 
+	{
+		std::string JSONRaw{};
+		_AppendJSONRaw(JSONRaw, str);
 		return JSONRaw;
 	}
 
@@ -110,13 +127,130 @@ namespace CU
 			const std::string message_;
 	};
 
+	// Every allocation of JSONItem/JSONArray/JSONObject (strings, keys, vectors, maps and nested nodes)
+	// comes from the memory resource current on the calling thread when the value is created:
+	// the resource of the innermost JSONMemoryScope, or std::pmr::get_default_resource() without one.
+	// Each value releases its memory to the resource it was allocated from, so values created under
+	// different resources can be mixed freely, but a resource must outlive every value allocated from it.
+	std::pmr::memory_resource* GetMemoryResource() noexcept;
+
+	class JSONMemoryScope
+	{
+		public:
+			JSONMemoryScope(std::pmr::memory_resource* resource);
+			~JSONMemoryScope();
+
+			JSONMemoryScope(const JSONMemoryScope &) = delete;
+			JSONMemoryScope &operator=(const JSONMemoryScope &) = delete;
+
+		private:
+			std::pmr::memory_resource* prev_;
+	};
+
+	template <typename _Node, typename... _Args>
+	_Node* _NewNode(_Args &&...args)
+	{
+		auto resource = GetMemoryResource();
+		void* ptr = resource->allocate(sizeof(_Node), alignof(_Node));
+		try {
+			return new (ptr) _Node(std::forward<_Args>(args)...);
+		} catch (...) {
+			resource->deallocate(ptr, sizeof(_Node), alignof(_Node));
+			throw;
+		}
+	}
+
+	// A node is always allocated from the resource its containers were created with.
+	template <typename _Node>
+	void _DeleteNode(_Node* node) noexcept
+	{
+		auto resource = node->resource();
+		node->~_Node();
+		resource->deallocate(node, sizeof(_Node), alignof(_Node));
+	}
+
+	class JSONItem;
 	class JSONObject;
 	class JSONArray;
+	class JSONParser;
+	class _CBORReader;
+
+	// What a JSONArray or JSONObject keeps about its content: the hash, the length of
+	// toString() and, with cacheText(), the text, each 0 / null until computed. Computing
+	// them records the container as the parent of the containers among its items. Every
+	// member that changes the content or hands out a mutable reference to an item drops
+	// the caches from there up to the root, also when called on a container held by
+	// reference from before. A container with nothing cached has nothing cached above it,
+	// which ends the walk. A reference to a scalar item is only good for writes until the
+	// containers above it cache again; take it afresh after that.
+	class _JSONCache
+	{
+		protected:
+			friend class JSONItem;
+
+			mutable std::atomic<size_t> hash_{0};
+			mutable std::atomic<size_t> textSize_{0};
+			mutable std::atomic<std::string*> text_{nullptr};
+			mutable std::atomic<bool> cacheText_{false};
+			mutable std::atomic<const _JSONCache*> parent_{nullptr};
+
+			_JSONCache() noexcept = default;
+			_JSONCache(const _JSONCache &) = delete;
+			_JSONCache &operator=(const _JSONCache &) = delete;
+			~_JSONCache();
+
+			void _Invalidate() const noexcept;
+			void _Adopt(const JSONItem &item) const noexcept;
+			void _TakeCache(_JSONCache &other) noexcept;
+	};
 
 	enum class ItemType : uint8_t {ITEM_NULL, BOOLEAN, INTEGER, LONG, DOUBLE, STRING, ARRAY, OBJECT};
 
+	// Bytes a value holds in its memory resource, by what they store: nodes are nested
+	// containers, array slots and map nodes, strings the buffers of strings and keys too
+	// long for the string itself, buckets the hash tables, order the lists of pointers to
+	// the map nodes that keep the member order, and slack the capacity not in use. Map
+	// nodes are sized from the node layout of libstdc++, libc++ or MSVC, including a cached
+	// hash code where the library keeps one; allocator overhead is not included.
+	struct JSONMemoryUsage
+	{
+		size_t nodes;
+		size_t strings;
+		size_t buckets;
+		size_t order;
+		size_t slack;
+
+		size_t total() const noexcept;
+		JSONMemoryUsage &operator+=(const JSONMemoryUsage &other) noexcept;
+	};
+
 	typedef char ItemNull;
-	typedef std::variant<ItemNull, bool, int, int64_t, double, std::string, JSONArray*, JSONObject*> ItemValue;
+
+	// Text of a number parsed with JSONParser::Options::lazyNumbers, held instead of the
+	// converted value of an INTEGER, LONG or DOUBLE item until it is read. Fits in the
+	// space of the string alternative, so it never allocates.
+	struct _RawNumber
+	{
+		char text[sizeof(std::pmr::string) - 1];
+		uint8_t size;
+
+		std::string_view view() const noexcept
+		{
+			return std::string_view(text, size);
+		}
+
+		bool operator==(const _RawNumber &other) const noexcept
+		{
+			return (view() == other.view());
+		}
+	};
+
+	typedef std::variant<ItemNull, bool, int, int64_t, double, std::pmr::string, JSONArray*, JSONObject*> ItemValue;
+
+	// What a JSONItem stores: the alternatives of ItemValue, plus the text of a lazy number
+	// and the std::string_view of a STRING item parsed with JSONParser::Options::inSitu,
+	// still in the parsed buffer. value() converts these two.
+	typedef std::variant<ItemNull, bool, int, int64_t, double, std::pmr::string, JSONArray*, JSONObject*, _RawNumber, std::string_view> _ItemStorage;
 
 	class JSONItem
 	{
@@ -124,7 +258,7 @@ namespace CU
 			struct _Init_Val
 			{
 				ItemType type;
-				ItemValue value;
+				_ItemStorage value;
 			};
 			static _Init_Val _To_Init_Val(const std::string &JSONRaw);
 
@@ -137,6 +271,8 @@ namespace CU
 			JSONItem(const std::string &value);
 			JSONItem(const JSONArray &value);
 			JSONItem(const JSONObject &value);
+			JSONItem(JSONArray &&value);
+			JSONItem(JSONObject &&value);
 			JSONItem(const JSONItem &other);
 			JSONItem(JSONItem &&other) noexcept;
 			JSONItem(_Init_Val &&initVal) noexcept;
@@ -144,6 +280,7 @@ namespace CU
 			
 			JSONItem &operator()(const JSONItem &other);
 			JSONItem &operator=(const JSONItem &other);
+			JSONItem &operator=(JSONItem &&other) noexcept;
 			bool operator==(const JSONItem &other) const;
 			bool operator!=(const JSONItem &other) const;
 
@@ -151,6 +288,10 @@ namespace CU
 			ItemValue value() const;
 			void clear();
 			size_t size() const;
+			size_t hash() const;
+			size_t serializedSize() const;
+			JSONMemoryUsage memoryUsage() const;
+			void shrinkToFit();
 
 			bool toBoolean() const;
 			int toInt() const;
@@ -160,17 +301,37 @@ namespace CU
 			JSONArray toArray() const;
 			JSONObject toObject() const;
 			std::string toRaw() const;
+
+			JSONArray &asArray();
+			JSONObject &asObject();
+			const JSONArray &asArray() const;
+			const JSONObject &asObject() const;
+			std::string_view asString() const;
 			
 		private:
+			friend class JSONArray;
+			friend class JSONObject;
+			friend class JSONParser;
+			friend class _CBORReader;
+			friend class _JSONCache;
+			friend void _WriteRaw(const JSONItem &item, std::string &buffer);
+
 			ItemType type_;
-			ItemValue value_;
+			_ItemStorage value_;
+
+			void _Release() noexcept;
+			void _Notify() const noexcept;
+			void _Detach() const noexcept;
+			void _CopyValue(const JSONItem &other);
+			ItemValue _Value() const;
+			void _CacheText() const noexcept;
 	};
 
-	class JSONArray
+	class JSONArray : public _JSONCache
 	{
 		public:
-			typedef std::vector<JSONItem>::iterator Iterator;
-			typedef std::vector<JSONItem>::const_iterator ConstIterator;
+			typedef std::pmr::vector<JSONItem>::iterator Iterator;
+			typedef std::pmr::vector<JSONItem>::const_iterator ConstIterator;
 
 			JSONArray();
 			JSONArray(const size_t &init_size);
@@ -206,15 +367,31 @@ namespace CU
 			std::vector<JSONObject> toListObject() const;
 
 			JSONItem at(const size_t &pos) const;
+			JSONItem* lookup(const size_t &pos);
+			const JSONItem* lookup(const size_t &pos) const;
 			Iterator find(const JSONItem &item);
 			void add(const JSONItem &item);
 			void remove(const JSONItem &item);
+			void insert(const size_t &pos, const JSONItem &item);
+			void erase(const size_t &pos);
 			void resize(const size_t &new_size);
 			void clear();
 			size_t size() const;
 			bool empty() const;
 			std::vector<JSONItem> data() const;
 			std::string toString() const;
+			std::pmr::memory_resource* resource() const;
+			size_t hash() const;
+			size_t serializedSize() const;
+			JSONMemoryUsage memoryUsage() const;
+			// Gives back unused capacity of vectors, strings and hash tables, recursively.
+			void shrinkToFit();
+			// Keeps the text of this container between serializations, and that of the large
+			// containers inside it once it has been written. A write drops the text of the
+			// containers from the change up to the root, so writing again only redoes the path
+			// to the change.
+			// The text is held on the heap, outside the memory resource. false drops it all.
+			void cacheText(const bool &enable);
 
 			JSONItem &front();
 			JSONItem &back();
@@ -224,12 +401,65 @@ namespace CU
 			ConstIterator end() const;
 			
 		private:
-			std::vector<JSONItem> data_;
+			friend class JSONItem;
+			friend class JSONParser;
+			friend class _CBORReader;
+			friend void _WriteRaw(const JSONArray &array, std::string &buffer);
+
+			std::pmr::vector<JSONItem> data_;
+
+			const std::string &_Text() const;
 	};
 
-	class JSONObject
+	// Walks the members of a JSONObject in insertion order. The object keeps a pointer to
+	// each map node in that order, so a step neither hashes a key nor allocates.
+	template <typename _Entry>
+	class _EntryIterator
 	{
 		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef std::remove_const_t<_Entry> value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef _Entry* pointer;
+			typedef _Entry& reference;
+
+			_EntryIterator() noexcept : pos_(nullptr) { }
+			explicit _EntryIterator(value_type* const* pos) noexcept : pos_(pos) { }
+			template <typename _Other, typename = std::enable_if_t<std::is_convertible_v<_Other*, _Entry*>>>
+			_EntryIterator(const _EntryIterator<_Other> &other) noexcept : pos_(other.base()) { }
+
+			reference operator*() const noexcept { return **pos_; }
+			pointer operator->() const noexcept { return *pos_; }
+			reference operator[](const difference_type &offset) const noexcept { return *pos_[offset]; }
+			_EntryIterator &operator++() noexcept { ++pos_; return *this; }
+			_EntryIterator operator++(int) noexcept { return _EntryIterator(pos_++); }
+			_EntryIterator &operator--() noexcept { --pos_; return *this; }
+			_EntryIterator operator--(int) noexcept { return _EntryIterator(pos_--); }
+			_EntryIterator &operator+=(const difference_type &offset) noexcept { pos_ += offset; return *this; }
+			_EntryIterator &operator-=(const difference_type &offset) noexcept { pos_ -= offset; return *this; }
+			_EntryIterator operator+(const difference_type &offset) const noexcept { return _EntryIterator(pos_ + offset); }
+			_EntryIterator operator-(const difference_type &offset) const noexcept { return _EntryIterator(pos_ - offset); }
+			difference_type operator-(const _EntryIterator &other) const noexcept { return pos_ - other.pos_; }
+			bool operator==(const _EntryIterator &other) const noexcept { return pos_ == other.pos_; }
+			bool operator!=(const _EntryIterator &other) const noexcept { return pos_ != other.pos_; }
+			bool operator<(const _EntryIterator &other) const noexcept { return pos_ < other.pos_; }
+			bool operator>(const _EntryIterator &other) const noexcept { return pos_ > other.pos_; }
+			bool operator<=(const _EntryIterator &other) const noexcept { return pos_ <= other.pos_; }
+			bool operator>=(const _EntryIterator &other) const noexcept { return pos_ >= other.pos_; }
+			value_type* const* base() const noexcept { return pos_; }
+
+		private:
+			value_type* const* pos_;
+	};
+
+	class JSONObject : public _JSONCache
+	{
+		public:
+			// Members are std::pairs, so structured bindings give a const key and the value.
+			typedef std::pair<const std::pmr::string, JSONItem> Entry;
+			typedef _EntryIterator<Entry> Iterator;
+			typedef _EntryIterator<const Entry> ConstIterator;
+
 			JSONObject();
 			JSONObject(const std::string &JSONString);
 			JSONObject(const std::unordered_map<std::string, JSONItem> &data, const std::vector<std::string> &order);
@@ -247,6 +477,8 @@ namespace CU
 			
 			bool contains(const std::string &key) const;
 			JSONItem at(const std::string &key) const;
+			JSONItem* lookup(const std::string_view &key);
+			const JSONItem* lookup(const std::string_view &key) const;
 			void add(const std::string &key, const JSONItem &value);
 			void remove(const std::string &key);
 			void clear();
@@ -254,8 +486,18 @@ namespace CU
 			bool empty() const;
 			std::unordered_map<std::string, JSONItem> data() const;
 			std::vector<std::string> order() const;
+			Iterator begin();
+			Iterator end();
+			ConstIterator begin() const;
+			ConstIterator end() const;
 			std::string toString() const;
 			std::string toFormatedString() const;
+			std::pmr::memory_resource* resource() const;
+			size_t hash() const;
+			size_t serializedSize() const;
+			JSONMemoryUsage memoryUsage() const;
+			void shrinkToFit();
+			void cacheText(const bool &enable);
 
 			struct JSONPair
 			{
@@ -265,9 +507,25 @@ namespace CU
 			std::vector<JSONPair> toPairs() const;
 
 		private:
-			std::unordered_map<std::string, JSONItem> data_;
-			std::vector<std::string> order_;
+			friend class JSONItem;
+			friend class JSONParser;
+			friend class _CBORReader;
+			friend void _WriteRaw(const JSONObject &object, std::string &buffer);
+
+			std::pmr::unordered_map<std::pmr::string, JSONItem> data_;
+			// The members of data_ in insertion order. Map nodes never move, not even on rehash.
+			std::pmr::vector<Entry*> order_;
+
+			void _Assign(const JSONObject &other);
+			const std::string &_Text() const;
 	};
+
+	// Append the text toRaw() and toString() return, without a temporary string per value.
+	void _WriteRaw(const JSONItem &item, std::string &buffer);
+	void _WriteRaw(const JSONArray &array, std::string &buffer);
+	void _WriteRaw(const JSONObject &object, std::string &buffer);
+	void _AppendJSONInteger(std::string &buffer, const int64_t &value);
+	void _AppendJSONDouble(std::string &buffer, const double &value);
 }
 
 namespace std
@@ -277,7 +535,7 @@ namespace std
 	{
 		size_t operator()(const CU::JSONItem &val) const
 		{
-			return reinterpret_cast<size_t>(std::addressof(val));
+			return val.hash();
 		}
 	};
 
@@ -286,7 +544,7 @@ namespace std
 	{
 		size_t operator()(const CU::JSONArray &val) const
 		{
-			return reinterpret_cast<size_t>(std::addressof(val));
+			return val.hash();
 		}
 	};
 
@@ -295,7 +553,7 @@ namespace std
 	{
 		size_t operator()(const CU::JSONObject &val) const
 		{
-			return reinterpret_cast<size_t>(std::addressof(val));
+			return val.hash();
 		}
 	};
 }
@@ -0,0 +1,383 @@
+#include "CuJSONParallel.h"
+#include "CuJSONStats.h"
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace CU
+{
+	namespace
+	{
+		// Roots with fewer elements per thread than this are not worth a thread.
+		constexpr size_t _MinThreadElements = 256;
+		constexpr size_t _ChunksPerThread = 4;
+
+		// Splits [0, count) into consecutive ranges and has write(begin, end, chunk) serialize
+		// each of them into its own chunk.
+		template <typename _Write>
+		std::vector<std::string> _WriteChunks(const size_t &count, const size_t &threads, const _Write &write)
+		{
+			const auto workers = _WorkerCount(count, threads, _MinThreadElements);
+			if (workers == 1) {
+				std::vector<std::string> chunks(1);
+				write(0, count, chunks.front());
+				return chunks;
+			}
+			const auto chunkCount = workers * _ChunksPerThread;
+			std::vector<std::string> chunks(chunkCount);
+			_ParallelFor(chunkCount, workers, [&](const size_t &chunk, const size_t &) {
+				write(count * chunk / chunkCount, count * (chunk + 1) / chunkCount, chunks[chunk]);
+			});
+			return chunks;
+		}
+
+		std::vector<std::string> _ArrayChunks(const JSONArray &array, const size_t &threads)
+		{
+			return _WriteChunks(array.size(), threads, [&array](const size_t &begin, const size_t &end, std::string &chunk) {
+				for (auto pos = begin; pos < end; pos++) {
+					if (pos != 0) {
+						chunk += ',';
+					}
+					_WriteRaw(*(array.begin() + pos), chunk);
+				}
+			});
+		}
+
+		std::vector<std::string> _ObjectChunks(const JSONObject &object, const size_t &threads)
+		{
+			const auto members = object.begin();
+			return _WriteChunks(object.size(), threads, [&members](const size_t &begin, const size_t &end, std::string &chunk) {
+				for (auto pos = begin; pos < end; pos++) {
+					if (pos != 0) {
+						chunk += ',';
+					}
+					_AppendJSONRaw(chunk, members[pos].first);
+					chunk += ':';
+					_WriteRaw(members[pos].second, chunk);
+				}
+			});
+		}
+
+		void _Join(const std::vector<std::string> &chunks, const char &open, const char &close, std::string &buffer)
+		{
+			size_t size = 2;
+			for (const auto &chunk : chunks) {
+				size += chunk.size();
+			}
+			buffer.reserve(buffer.size() + size);
+			buffer += open;
+			for (const auto &chunk : chunks) {
+				buffer += chunk;
+			}
+			buffer += close;
+		}
+
+		void _WritePieces(const int &fd, const std::vector<std::string_view> &pieces)
+		{
+			const auto fail = []() {
+				throw JSONExcept(std::string("Failed to write JSON: ") + std::strerror(errno));
+			};
+#if defined(_WIN32)
+			for (const auto &piece : pieces) {
+				size_t pos = 0;
+				while (pos < piece.size()) {
+					const auto length = static_cast<unsigned int>(std::min<size_t>(piece.size() - pos, INT_MAX));
+					const auto written = _write(fd, piece.data() + pos, length);
+					if (written < 0) {
+						fail();
+					}
+					pos += static_cast<size_t>(written);
+				}
+			}
+#else
+#if defined(IOV_MAX)
+			constexpr size_t maxVectors = IOV_MAX;
+#else
+			constexpr size_t maxVectors = 16;
+#endif
+			std::vector<iovec> vectors{};
+			vectors.reserve(pieces.size());
+			for (const auto &piece : pieces) {
+				if (!piece.empty()) {
+					vectors.emplace_back(iovec{const_cast<char*>(piece.data()), piece.size()});
+				}
+			}
+			size_t pos = 0;
+			while (pos < vectors.size()) {
+				const auto batch = static_cast<int>(std::min(vectors.size() - pos, maxVectors));
+				auto written = writev(fd, vectors.data() + pos, batch);
+				if (written < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					fail();
+				}
+				// Resume a short write inside the vector it stopped in.
+				while (pos < vectors.size() && static_cast<size_t>(written) >= vectors[pos].iov_len) {
+					written -= static_cast<ssize_t>(vectors[pos].iov_len);
+					pos++;
+				}
+				if (written > 0) {
+					vectors[pos].iov_base = static_cast<char*>(vectors[pos].iov_base) + written;
+					vectors[pos].iov_len -= static_cast<size_t>(written);
+				}
+			}
+#endif
+		}
+
+		// Returns the number of bytes written.
+		size_t _WriteChunksTo(const int &fd, const std::vector<std::string> &chunks, const char &open, const char &close)
+		{
+			std::vector<std::string_view> pieces{};
+			pieces.reserve(chunks.size() + 2);
+			pieces.emplace_back(std::addressof(open), 1);
+			size_t size = 2;
+			for (const auto &chunk : chunks) {
+				pieces.emplace_back(chunk);
+				size += chunk.size();
+			}
+			pieces.emplace_back(std::addressof(close), 1);
+			_WritePieces(fd, pieces);
+			return size;
+		}
+
+		// Threads started by the first parallel call and kept for the later ones, so a call
+		// wakes its helpers instead of starting them. One call has the pool at a time; a
+		// call made meanwhile, from another thread or from inside a task, gets false and
+		// starts threads of its own.
+		class _WorkerPool
+		{
+			public:
+				_WorkerPool() :
+					busy_(),
+					mutex_(),
+					wake_(),
+					done_(),
+					threads_(),
+					job_(nullptr),
+					generation_(0),
+					helpers_(0),
+					claimed_(0),
+					active_(0),
+					stop_(false)
+				{ }
+
+				~_WorkerPool()
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						stop_ = true;
+					}
+					wake_.notify_all();
+					for (auto &thread : threads_) {
+						thread.join();
+					}
+				}
+
+				// Runs job(worker) for every worker below workers, worker 0 on the calling thread.
+				bool run(const size_t &workers, const std::function<void(const size_t &)> &job)
+				{
+					std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+					if (!busy.owns_lock()) {
+						return false;
+					}
+					try {
+						while (threads_.size() + 1 < workers) {
+							threads_.emplace_back(&_WorkerPool::_Loop, this);
+						}
+					} catch (const std::system_error &) {
+						// Fewer threads than asked for, the started ones and the caller do the rest.
+					}
+					const auto helpers = std::min(workers - 1, threads_.size());
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						job_ = std::addressof(job);
+						helpers_ = helpers;
+						claimed_ = 0;
+						active_ = helpers;
+						generation_++;
+					}
+					wake_.notify_all();
+					job(0);
+					std::unique_lock<std::mutex> lock(mutex_);
+					done_.wait(lock, [this]() { return (active_ == 0); });
+					job_ = nullptr;
+					return true;
+				}
+
+			private:
+				std::mutex busy_;
+				std::mutex mutex_;
+				std::condition_variable wake_;
+				std::condition_variable done_;
+				std::vector<std::thread> threads_;
+				const std::function<void(const size_t &)>* job_;
+				size_t generation_;
+				size_t helpers_;
+				size_t claimed_;
+				size_t active_;
+				bool stop_;
+
+				// Each thread takes at most one worker index per call.
+				void _Loop()
+				{
+					size_t seen = 0;
+					std::unique_lock<std::mutex> lock(mutex_);
+					for (;;) {
+						wake_.wait(lock, [this, &seen]() { return (stop_ || (generation_ != seen && claimed_ < helpers_)); });
+						if (stop_) {
+							return;
+						}
+						seen = generation_;
+						const auto worker = ++claimed_;
+						const auto job = job_;
+						lock.unlock();
+						(*job)(worker);
+						lock.lock();
+						if (--active_ == 0) {
+							done_.notify_all();
+						}
+					}
+				}
+		};
+
+		_WorkerPool &_Pool()
+		{
+			static _WorkerPool pool{};
+			return pool;
+		}
+	}
+}
+
+size_t CU::_WorkerCount(const size_t &count, const size_t &threads, const size_t &minimum) noexcept
+{
+	const auto hardware = (threads != 0) ? threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	return std::max<size_t>(std::min(hardware, count / std::max<size_t>(minimum, 1)), 1);
+}
+
+void CU::_ParallelFor(const size_t &chunks, const size_t &workers, const std::function<void(const size_t &, const size_t &)> &task)
+{
+	std::atomic<size_t> next{0};
+	std::exception_ptr error{};
+	std::mutex errorMutex{};
+	const auto run = [&](const size_t &worker) {
+		try {
+			for (auto chunk = next.fetch_add(1); chunk < chunks; chunk = next.fetch_add(1)) {
+				task(chunk, worker);
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+			next.store(chunks);
+		}
+	};
+	if (workers <= 1 || !_Pool().run(workers, run)) {
+		std::vector<std::thread> pool{};
+		pool.reserve(workers - 1);
+		try {
+			while (pool.size() + 1 < workers) {
+				pool.emplace_back(run, pool.size() + 1);
+			}
+		} catch (const std::system_error &) {
+			// Fewer threads than asked for, the started ones and the caller do the rest.
+		}
+		run(0);
+		for (auto &thread : pool) {
+			thread.join();
+		}
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void CU::WriteParallel(const JSONItem &item, std::string &buffer, const size_t &threads)
+{
+	if (item.type() == ItemType::ARRAY) {
+		WriteParallel(item.asArray(), buffer, threads);
+	} else if (item.type() == ItemType::OBJECT) {
+		WriteParallel(item.asObject(), buffer, threads);
+	} else {
+		_WriteRaw(item, buffer);
+	}
+}
+
+void CU::WriteParallel(const JSONArray &array, std::string &buffer, const size_t &threads)
+{
+	_CU_STATS_PHASE(SERIALIZE, 0);
+	const auto begin = buffer.size();
+	_Join(_ArrayChunks(array, threads), '[', ']', buffer);
+	_CU_STATS_OUTPUT(buffer.size() - begin);
+	(void)begin;
+}
+
+void CU::WriteParallel(const JSONObject &object, std::string &buffer, const size_t &threads)
+{
+	_CU_STATS_PHASE(SERIALIZE, 0);
+	const auto begin = buffer.size();
+	_Join(_ObjectChunks(object, threads), '{', '}', buffer);
+	_CU_STATS_OUTPUT(buffer.size() - begin);
+	(void)begin;
+}
+
+std::string CU::ToParallelString(const JSONItem &item, const size_t &threads)
+{
+	std::string buffer{};
+	WriteParallel(item, buffer, threads);
+	return buffer;
+}
+
+std::string CU::ToParallelString(const JSONArray &array, const size_t &threads)
+{
+	std::string buffer{};
+	WriteParallel(array, buffer, threads);
+	return buffer;
+}
+
+std::string CU::ToParallelString(const JSONObject &object, const size_t &threads)
+{
+	std::string buffer{};
+	WriteParallel(object, buffer, threads);
+	return buffer;
+}
+
+void CU::WriteParallel(const JSONItem &item, const int &fd, const size_t &threads)
+{
+	if (item.type() == ItemType::ARRAY) {
+		WriteParallel(item.asArray(), fd, threads);
+	} else if (item.type() == ItemType::OBJECT) {
+		WriteParallel(item.asObject(), fd, threads);
+	} else {
+		std::string buffer{};
+		_WriteRaw(item, buffer);
+		_WritePieces(fd, {buffer});
+	}
+}
+
+void CU::WriteParallel(const JSONArray &array, const int &fd, const size_t &threads)
+{
+	_CU_STATS_PHASE(SERIALIZE, 0);
+	const auto size = _WriteChunksTo(fd, _ArrayChunks(array, threads), '[', ']');
+	_CU_STATS_OUTPUT(size);
+	(void)size;
+}
+
+void CU::WriteParallel(const JSONObject &object, const int &fd, const size_t &threads)
+{
+	_CU_STATS_PHASE(SERIALIZE, 0);
+	const auto size = _WriteChunksTo(fd, _ObjectChunks(object, threads), '{', '}');
+	_CU_STATS_OUTPUT(size);
+	(void)size;
+}
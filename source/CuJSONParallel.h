@@ -0,0 +1,40 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONPARALLEL_
+#define _CU_JSONPARALLEL_
+
+#include "CuJSONObject.h"
+#include <functional>
+
+namespace CU
+{
+	// Serializes the elements or members of the root container on several threads, each
+	// range into its own buffer, and joins the buffers in order into a presized output.
+	// The text is the same as toString(). threads == 0 uses every hardware thread; small
+	// roots are written on the calling thread. The tree must not be modified meanwhile.
+	void WriteParallel(const JSONItem &item, std::string &buffer, const size_t &threads = 0);
+	void WriteParallel(const JSONArray &array, std::string &buffer, const size_t &threads = 0);
+	void WriteParallel(const JSONObject &object, std::string &buffer, const size_t &threads = 0);
+
+	std::string ToParallelString(const JSONItem &item, const size_t &threads = 0);
+	std::string ToParallelString(const JSONArray &array, const size_t &threads = 0);
+	std::string ToParallelString(const JSONObject &object, const size_t &threads = 0);
+
+	// Hands the per-thread buffers to writev() (write() on Windows) without joining them.
+	// Throws JSONExcept when the descriptor fails.
+	void WriteParallel(const JSONItem &item, const int &fd, const size_t &threads = 0);
+	void WriteParallel(const JSONArray &array, const int &fd, const size_t &threads = 0);
+	void WriteParallel(const JSONObject &object, const int &fd, const size_t &threads = 0);
+
+	// Threads worth starting for count units of work, at least minimum units each; threads == 0
+	// allows every hardware thread.
+	size_t _WorkerCount(const size_t &count, const size_t &threads, const size_t &minimum) noexcept;
+	// Runs task(chunk, worker) for every chunk below chunks. Chunks are claimed in turn by
+	// workers threads including the caller, so uneven chunks still balance; worker is below
+	// workers and indexes per-thread state. The other threads are kept for later calls.
+	// Rethrows the first exception of a task once every thread has stopped.
+	void _ParallelFor(const size_t &chunks, const size_t &workers, const std::function<void(const size_t &, const size_t &)> &task);
+}
+
+#endif // _CU_JSONPARALLEL_
@@ -0,0 +1,990 @@
+#include "CuJSONParser.h"
+#include "CuJSONInternal.h"
+#include "CuJSONSchema.h"
+#include "CuJSONStats.h"
+#include <charconv>
+#include <cstring>
+
+namespace CU
+{
+	namespace
+	{
+		constexpr size_t _SSOCapacity = 15;
+
+		// Blocks up to 16 MiB are pooled, so the vectors of big arrays are recycled as well.
+		std::pmr::pool_options _DocumentPoolOptions() noexcept
+		{
+			std::pmr::pool_options options{};
+			options.max_blocks_per_chunk = 0;
+			options.largest_required_pool_block = 16 << 20;
+			return options;
+		}
+
+		inline int _HexValue(const char &ch) noexcept
+		{
+			if (ch >= '0' && ch <= '9') {
+				return ch - '0';
+			} else if (ch >= 'a' && ch <= 'f') {
+				return ch - 'a' + 10;
+			} else if (ch >= 'A' && ch <= 'F') {
+				return ch - 'A' + 10;
+			}
+			return -1;
+		}
+
+		inline void _AppendUTF8(std::string &str, const uint32_t &codePoint)
+		{
+			if (codePoint < 0x80) {
+				str += static_cast<char>(codePoint);
+			} else if (codePoint < 0x800) {
+				str += static_cast<char>(0xC0 | (codePoint >> 6));
+				str += static_cast<char>(0x80 | (codePoint & 0x3F));
+			} else if (codePoint < 0x10000) {
+				str += static_cast<char>(0xE0 | (codePoint >> 12));
+				str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				str += static_cast<char>(0x80 | (codePoint & 0x3F));
+			} else {
+				str += static_cast<char>(0xF0 | (codePoint >> 18));
+				str += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				str += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+	}
+}
+
+CU::JSONDocument::JSONDocument() : pool_(_DocumentPoolOptions()), root_() { }
+
+CU::JSONDocument::JSONDocument(std::pmr::memory_resource* upstream) : pool_(_DocumentPoolOptions(), upstream), root_() { }
+
+CU::JSONDocument::~JSONDocument()
+{
+	clear();
+}
+
+CU::JSONItem &CU::JSONDocument::root()
+{
+	return root_;
+}
+
+const CU::JSONItem &CU::JSONDocument::root() const
+{
+	return root_;
+}
+
+CU::JSONArray &CU::JSONDocument::array()
+{
+	return root_.asArray();
+}
+
+CU::JSONObject &CU::JSONDocument::object()
+{
+	return root_.asObject();
+}
+
+const CU::JSONArray &CU::JSONDocument::array() const
+{
+	return root_.asArray();
+}
+
+const CU::JSONObject &CU::JSONDocument::object() const
+{
+	return root_.asObject();
+}
+
+void CU::JSONDocument::clear()
+{
+	root_.clear();
+}
+
+std::pmr::memory_resource* CU::JSONDocument::resource()
+{
+	return std::addressof(pool_);
+}
+
+CU::JSONParser &CU::_ThreadParser()
+{
+	thread_local JSONParser parser{};
+	return parser;
+}
+
+// Depth is limited by default since destroying a value recurses once per nesting level.
+CU::JSONParser::Options::Options() :
+	maxDepth(1024),
+	maxDocumentSize(SIZE_MAX),
+	maxStringLength(SIZE_MAX),
+	maxElements(SIZE_MAX),
+	lazyNumbers(false),
+	inSitu(false)
+{ }
+
+CU::JSONParser::JSONParser() :
+	options_(),
+	begin_(nullptr),
+	cur_(nullptr),
+	end_(nullptr),
+	elements_(0),
+	scratch_(),
+	stack_(),
+	schema_(nullptr),
+	seen_(),
+	target_(nullptr),
+	pending_(),
+	offset_(0),
+	scanned_(0),
+	scanDepth_(0),
+	inString_(false),
+	escaped_(false),
+	started_(false),
+	suspend_(false),
+	opened_(false)
+{ }
+
+CU::JSONParser::JSONParser(const Options &options) :
+	options_(options),
+	begin_(nullptr),
+	cur_(nullptr),
+	end_(nullptr),
+	elements_(0),
+	scratch_(),
+	stack_(),
+	schema_(nullptr),
+	seen_(),
+	target_(nullptr),
+	pending_(),
+	offset_(0),
+	scanned_(0),
+	scanDepth_(0),
+	inString_(false),
+	escaped_(false),
+	started_(false),
+	suspend_(false),
+	opened_(false)
+{ }
+
+CU::JSONParser::~JSONParser() { }
+
+const CU::JSONParser::Options &CU::JSONParser::options() const
+{
+	return options_;
+}
+
+void CU::JSONParser::setOptions(const Options &options)
+{
+	options_ = options;
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONDocument &document)
+{
+	JSONMemoryScope scope(document.resource());
+	auto &root = document.root_;
+	size_t pos = 0;
+	while (pos < text.size() && _IsSpace(text[pos])) {
+		pos++;
+	}
+	// Keep the root container (and the capacity of its vector/map) if the root type is unchanged.
+	if (pos < text.size() && text[pos] == '{' && root.type_ == ItemType::OBJECT && root.asObject().resource() == document.resource()) {
+		parse(text, root.asObject());
+	} else if (pos < text.size() && text[pos] == '[' && root.type_ == ItemType::ARRAY && root.asArray().resource() == document.resource()) {
+		parse(text, root.asArray());
+	} else {
+		root.clear();
+		parse(text, root);
+	}
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONArray &array)
+{
+	_Parse(text, array, nullptr);
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONObject &object)
+{
+	_Parse(text, object, nullptr);
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONItem &item)
+{
+	_Parse(text, item, nullptr);
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONArray &array, const JSONSchema &schema)
+{
+	_Parse(text, array, schema.root());
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONObject &object, const JSONSchema &schema)
+{
+	_Parse(text, object, schema.root());
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONItem &item, const JSONSchema &schema)
+{
+	_Parse(text, item, schema.root());
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONArray &array, const JSONProjection &projection)
+{
+	_Parse(text, array, projection.root());
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONObject &object, const JSONProjection &projection)
+{
+	_Parse(text, object, projection.root());
+}
+
+void CU::JSONParser::parse(const std::string_view &text, JSONItem &item, const JSONProjection &projection)
+{
+	_Parse(text, item, projection.root());
+}
+
+void CU::JSONParser::_Parse(const std::string_view &text, JSONArray &array, const _SchemaNode* schema)
+{
+	_CU_STATS_PHASE(PARSE, text.size());
+	_Begin(text);
+	schema_ = schema;
+	array.clear();
+	_SkipSpace();
+	if (cur_ == end_ || *cur_ != '[') {
+		_Throw("JSONArray expected");
+	} else if (schema_ != nullptr && !schema_->accepts('[')) {
+		_Reject("Unexpected type");
+	}
+	cur_++;
+	_CU_STATS_NODE(ItemType::ARRAY);
+	elements_++;
+	_Push(std::addressof(array), nullptr);
+	_ParseValues(_NextItem(true));
+	_End();
+}
+
+void CU::JSONParser::_Parse(const std::string_view &text, JSONObject &object, const _SchemaNode* schema)
+{
+	_CU_STATS_PHASE(PARSE, text.size());
+	_Begin(text);
+	schema_ = schema;
+	object.clear();
+	_SkipSpace();
+	if (cur_ == end_ || *cur_ != '{') {
+		_Throw("JSONObject expected");
+	} else if (schema_ != nullptr && !schema_->accepts('{')) {
+		_Reject("Unexpected type");
+	}
+	cur_++;
+	_CU_STATS_NODE(ItemType::OBJECT);
+	elements_++;
+	_Push(nullptr, std::addressof(object));
+	_ParseValues(_NextItem(true));
+	_End();
+}
+
+void CU::JSONParser::_Parse(const std::string_view &text, JSONItem &item, const _SchemaNode* schema)
+{
+	_CU_STATS_PHASE(PARSE, text.size());
+	_Begin(text);
+	schema_ = schema;
+	item.clear();
+	_ParseValues(std::addressof(item));
+	_End();
+}
+
+void CU::JSONParser::begin(JSONItem &item)
+{
+	item.clear();
+	target_ = std::addressof(item);
+	pending_.clear();
+	begin_ = pending_.data();
+	cur_ = begin_;
+	end_ = begin_;
+	elements_ = 0;
+	stack_.clear();
+	schema_ = nullptr;
+	seen_.clear();
+	offset_ = 0;
+	scanned_ = 0;
+	scanDepth_ = 0;
+	inString_ = false;
+	escaped_ = false;
+	started_ = false;
+	suspend_ = false;
+	opened_ = false;
+}
+
+// A value always ends in front of a separator inside a container, so the parser can stop
+// there in _NextItem() with nothing half read, and nothing before it is needed again.
+void CU::JSONParser::feed(const std::string_view &chunk)
+{
+	_CU_STATS_PHASE(PARSE, chunk.size());
+	if (target_ == nullptr) {
+		throw JSONExcept("JSONParser::begin() expected");
+	}
+	pending_.append(chunk.data(), chunk.size());
+	if (offset_ + pending_.size() > options_.maxDocumentSize) {
+		begin_ = pending_.data();
+		cur_ = begin_;
+		_Throw("Maximum document size exceeded");
+	}
+	size_t separator = std::string::npos;
+	for (; scanned_ < pending_.size(); scanned_++) {
+		const char ch = pending_[scanned_];
+		if (inString_) {
+			if (escaped_) {
+				escaped_ = false;
+			} else if (ch == '\\') {
+				escaped_ = true;
+			} else if (ch == '\"') {
+				inString_ = false;
+			}
+			continue;
+		}
+		switch (ch) {
+			case '\"':
+				inString_ = true;
+				break;
+			case '{':
+			case '[':
+				scanDepth_++;
+				break;
+			case '}':
+			case ']':
+				scanDepth_ = (scanDepth_ != 0) ? scanDepth_ - 1 : 0;
+				break;
+			case ',':
+				if (scanDepth_ != 0) {
+					separator = scanned_;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	if (separator != std::string::npos) {
+		suspend_ = true;
+		_Resume(separator);
+		suspend_ = false;
+		pending_.erase(0, separator);
+		offset_ += separator;
+		scanned_ -= separator;
+	}
+}
+
+void CU::JSONParser::finish()
+{
+	_CU_STATS_PHASE(PARSE, 0);
+	if (target_ == nullptr) {
+		throw JSONExcept("JSONParser::begin() expected");
+	}
+	_Resume(pending_.size());
+	target_ = nullptr;
+	pending_.clear();
+}
+
+void CU::JSONParser::_Begin(const std::string_view &text)
+{
+	begin_ = text.data();
+	cur_ = begin_;
+	end_ = begin_ + text.size();
+	elements_ = 0;
+	stack_.clear();
+	schema_ = nullptr;
+	seen_.clear();
+	offset_ = 0;
+	suspend_ = false;
+	if (text.size() > options_.maxDocumentSize) {
+		_Throw("Maximum document size exceeded");
+	}
+}
+
+// The new frame takes the schema of the value being parsed.
+void CU::JSONParser::_Push(JSONArray* array, JSONObject* object)
+{
+	if (stack_.size() >= options_.maxDepth) {
+		_Throw("Maximum depth exceeded");
+	}
+	const auto seen = seen_.size();
+	if (schema_ != nullptr && object != nullptr) {
+		seen_.resize(seen + schema_->required.size(), 0);
+	}
+	stack_.emplace_back(_Frame{array, object, schema_, seen, 0});
+	_CU_STATS_MAX(maxDepth, stack_.size());
+}
+
+// Checks the constraints that need the whole container, at its closing bracket.
+void CU::JSONParser::_Close(const _Frame &frame)
+{
+	if (frame.schema != nullptr) {
+		if (frame.array != nullptr) {
+			if (frame.items < frame.schema->minItems) {
+				_Reject("Too few items");
+			}
+		} else {
+			for (size_t slot = 0; slot < frame.schema->required.size(); slot++) {
+				if (seen_[frame.seen + slot] == 0) {
+					_Reject("Missing required key: " + *frame.schema->required[slot]);
+				}
+			}
+			seen_.resize(frame.seen);
+		}
+	}
+	stack_.pop_back();
+}
+
+// Parses pending_ up to end, from the start of the text or from where the last call stopped.
+void CU::JSONParser::_Resume(const size_t &end)
+{
+	begin_ = pending_.data();
+	cur_ = begin_;
+	end_ = begin_ + end;
+	if (!started_) {
+		started_ = true;
+		_ParseValues(target_);
+	} else if (!stack_.empty()) {
+		_ParseValues(_NextItem(opened_));
+	}
+	if (stack_.empty()) {
+		_End();
+	}
+}
+
+void CU::JSONParser::_End()
+{
+	_SkipSpace();
+	if (cur_ != end_) {
+		_Throw("Unexpected trailing characters");
+	}
+}
+
+// Parses values until the outermost container is closed. The nesting is kept in stack_,
+// never on the call stack, so the depth of the input does not matter.
+void CU::JSONParser::_ParseValues(JSONItem* item)
+{
+	while (item != nullptr) {
+		const bool opened = _ParseValue(*item);
+		item = _NextItem(opened);
+	}
+}
+
+bool CU::JSONParser::_ParseValue(JSONItem &item)
+{
+	_SkipSpace();
+	if (cur_ == end_) {
+		_Throw("Value expected");
+	}
+	if (++elements_ > options_.maxElements) {
+		_Throw("Maximum element count exceeded");
+	}
+	const char* start = cur_;
+	const auto schema = schema_;
+	if (schema != nullptr && !schema->accepts(*cur_)) {
+		_Reject("Unexpected type");
+	}
+	switch (*cur_) {
+		case '{':
+			{
+				cur_++;
+				auto object = _NewNode<JSONObject>();
+				item.type_ = ItemType::OBJECT;
+				item.value_ = object;
+				_Push(nullptr, object);
+				_CU_STATS_NODE(ItemType::OBJECT);
+				_CU_STATS_ADD(allocCount, 1);
+				_CU_STATS_ADD(allocBytes, sizeof(JSONObject));
+			}
+			return true;
+		case '[':
+			{
+				cur_++;
+				auto array = _NewNode<JSONArray>();
+				item.type_ = ItemType::ARRAY;
+				item.value_ = array;
+				_Push(array, nullptr);
+				_CU_STATS_NODE(ItemType::ARRAY);
+				_CU_STATS_ADD(allocCount, 1);
+				_CU_STATS_ADD(allocBytes, sizeof(JSONArray));
+			}
+			return true;
+		case '\"':
+			{
+				// Text fed in pieces is held in pending_, which is cut and reallocated.
+				std::string_view str{};
+				const bool inSitu = (options_.inSitu && begin_ != pending_.data() && _ParseStringView(str));
+				if (!inSitu) {
+					_ParseString();
+					str = scratch_;
+				}
+				if (schema != nullptr) {
+					const auto reason = schema->checkString(str);
+					if (reason != nullptr) {
+						cur_ = start;
+						_Reject(reason);
+					}
+				}
+				item.type_ = ItemType::STRING;
+				if (inSitu) {
+					item.value_ = str;
+				} else {
+					item.value_ = std::pmr::string(str.data(), str.size(), GetMemoryResource());
+					_CU_STATS_ADD(allocCount, (str.size() > _SSOCapacity) ? 1 : 0);
+					_CU_STATS_ADD(allocBytes, (str.size() > _SSOCapacity) ? str.size() + 1 : 0);
+				}
+				_CU_STATS_NODE(ItemType::STRING);
+			}
+			break;
+		case 't':
+			_ParseLiteral("true", 4);
+			item.type_ = ItemType::BOOLEAN;
+			item.value_ = true;
+			_CU_STATS_NODE(ItemType::BOOLEAN);
+			break;
+		case 'f':
+			_ParseLiteral("false", 5);
+			item.type_ = ItemType::BOOLEAN;
+			item.value_ = false;
+			_CU_STATS_NODE(ItemType::BOOLEAN);
+			break;
+		case 'n':
+			_ParseLiteral("null", 4);
+			item.type_ = ItemType::ITEM_NULL;
+			item.value_ = ItemNull();
+			_CU_STATS_NODE(ItemType::ITEM_NULL);
+			break;
+		default:
+			_ParseNumber(item);
+			if (schema != nullptr) {
+				const auto reason = schema->checkNumber(item);
+				if (reason != nullptr) {
+					cur_ = start;
+					_Reject(reason);
+				}
+			}
+			break;
+	}
+	return false;
+}
+
+// Returns the item receiving the next value of the innermost open container,
+// closing every container that ends before it; nullptr once the outermost one is closed.
+CU::JSONItem* CU::JSONParser::_NextItem(bool opened)
+{
+	while (!stack_.empty()) {
+		const auto frame = stack_.back();
+		_SkipSpace();
+		if (cur_ == end_) {
+			// Incremental parsing stops in front of a separator and continues from here.
+			if (suspend_) {
+				opened_ = opened;
+				return nullptr;
+			}
+			_Throw("Unterminated container");
+		}
+		const char ch = *cur_;
+		if (frame.array != nullptr) {
+			if (ch == ']') {
+				_Close(frame);
+				cur_++;
+			} else if (opened || ch == ',') {
+				if (!opened) {
+					cur_++;
+				}
+				schema_ = nullptr;
+				if (frame.schema != nullptr) {
+					if (frame.items >= frame.schema->maxItems) {
+						_Reject("Too many items");
+					}
+					stack_.back().items++;
+					schema_ = frame.schema->items;
+					if (_Skips(schema_)) {
+						_SkipValue();
+						opened = false;
+						continue;
+					}
+				}
+				return std::addressof(frame.array->data_.emplace_back());
+			} else {
+				_Throw("',' or ']' expected");
+			}
+		} else {
+			if (ch == '}') {
+				_Close(frame);
+				cur_++;
+			} else if (opened || ch == ',') {
+				if (!opened) {
+					cur_++;
+					_SkipSpace();
+				}
+				// nullptr when the member is skipped.
+				const auto item = _ObjectItem(frame);
+				if (item != nullptr) {
+					return item;
+				}
+			} else {
+				_Throw("',' or '}' expected");
+			}
+		}
+		opened = false;
+	}
+	return nullptr;
+}
+
+CU::JSONItem* CU::JSONParser::_ObjectItem(const _Frame &frame)
+{
+	if (cur_ == end_ || *cur_ != '\"') {
+		_Throw("Key expected");
+	}
+	const char* key = cur_;
+	_ParseString();
+	_SkipSpace();
+	if (cur_ == end_ || *cur_ != ':') {
+		_Throw("':' expected");
+	}
+	cur_++;
+	_CU_STATS_ADD(stringBytes, scratch_.size());
+	schema_ = nullptr;
+	if (frame.schema != nullptr) {
+		const auto property = frame.schema->property(scratch_);
+		if (property != nullptr) {
+			schema_ = property->node;
+			if (property->required != _SchemaNoSlot) {
+				seen_[frame.seen + property->required] = 1;
+			}
+		} else if (frame.schema->closed) {
+			cur_ = key;
+			_Reject("Unexpected key: " + scratch_);
+		} else {
+			schema_ = frame.schema->additional;
+		}
+		if (_Skips(schema_)) {
+			_SkipValue();
+			return nullptr;
+		}
+	}
+	auto &object = *frame.object;
+	// Duplicated keys keep their first position and the last value, like JSONObject::add().
+	auto result = object.data_.try_emplace(std::pmr::string(scratch_.data(), scratch_.size(), GetMemoryResource()));
+	if (result.second) {
+		object.order_.emplace_back(std::addressof(*result.first));
+	} else {
+		result.first->second.clear();
+	}
+	return std::addressof(result.first->second);
+}
+
+void CU::JSONParser::_ParseString()
+{
+	cur_++;
+	scratch_.clear();
+	for (;;) {
+		// Stop scanning as soon as the limit is exceeded instead of at the closing quote.
+		if (scratch_.size() > options_.maxStringLength) {
+			_Throw("Maximum string length exceeded");
+		}
+		const char* run = cur_;
+		const size_t remaining = options_.maxStringLength - scratch_.size();
+		const char* runEnd = (static_cast<size_t>(end_ - cur_) > remaining) ? cur_ + remaining + 1 : end_;
+		while (cur_ != runEnd && *cur_ != '\"' && *cur_ != '\\') {
+			cur_++;
+		}
+		scratch_.append(run, cur_ - run);
+		if (scratch_.size() > options_.maxStringLength) {
+			_Throw("Maximum string length exceeded");
+		} else if (cur_ == end_) {
+			_Throw("Unterminated string");
+		}
+		if (*cur_ == '\"') {
+			cur_++;
+			break;
+		}
+		cur_++;
+		if (cur_ == end_) {
+			_Throw("Unterminated string");
+		}
+		_CU_STATS_ADD(escapeCount, 1);
+		if (*cur_ != 'u') {
+			scratch_ += _GetEscapeChar(*cur_);
+			cur_++;
+			continue;
+		}
+		const auto readHex = [this]() -> uint32_t {
+			if (end_ - cur_ < 5) {
+				_Throw("Invalid unicode escape");
+			}
+			uint32_t value = 0;
+			for (size_t i = 1; i <= 4; i++) {
+				const int digit = _HexValue(cur_[i]);
+				if (digit < 0) {
+					_Throw("Invalid unicode escape");
+				}
+				value = (value << 4) | static_cast<uint32_t>(digit);
+			}
+			cur_ += 5;
+			return value;
+		};
+		uint32_t codePoint = readHex();
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF && end_ - cur_ >= 6 && cur_[0] == '\\' && cur_[1] == 'u') {
+			cur_++;
+			const uint32_t low = readHex();
+			if (low >= 0xDC00 && low <= 0xDFFF) {
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+			} else {
+				_AppendUTF8(scratch_, codePoint);
+				codePoint = low;
+			}
+		}
+		_AppendUTF8(scratch_, codePoint);
+	}
+	if (scratch_.size() > options_.maxStringLength) {
+		_Throw("Maximum string length exceeded");
+	}
+	_CU_STATS_ADD(stringBytes, scratch_.size());
+}
+
+// Takes the string at cur_ as a view into the text when it has no escape. Returns false,
+// leaving cur_, when it has one or breaks a limit, so _ParseString() handles it.
+bool CU::JSONParser::_ParseStringView(std::string_view &str)
+{
+	const char* first = cur_ + 1;
+	const auto quote = static_cast<const char*>(memchr(first, '\"', static_cast<size_t>(end_ - first)));
+	if (quote == nullptr || static_cast<size_t>(quote - first) > options_.maxStringLength) {
+		return false;
+	} else if (memchr(first, '\\', static_cast<size_t>(quote - first)) != nullptr) {
+		return false;
+	}
+	str = std::string_view(first, static_cast<size_t>(quote - first));
+	cur_ = quote + 1;
+	_CU_STATS_ADD(stringBytes, str.size());
+	return true;
+}
+
+// Numbers with a fraction or an exponent are DOUBLE, integers are INTEGER when they fit in int,
+// LONG when they fit in int64_t and DOUBLE otherwise.
+void CU::JSONParser::_ParseNumber(JSONItem &item)
+{
+	if (options_.lazyNumbers && _ParseRawNumber(item)) {
+		return;
+	}
+	const char* start = cur_;
+	bool integral = true;
+	while (cur_ != end_) {
+		const char ch = *cur_;
+		if (ch >= '0' && ch <= '9') {
+			cur_++;
+		} else if (ch == '.' || ch == 'e' || ch == 'E') {
+			integral = false;
+			cur_++;
+		} else if (ch == '-' || ch == '+') {
+			cur_++;
+		} else {
+			break;
+		}
+	}
+	if (start == cur_ || !(*start == '-' || (*start >= '0' && *start <= '9'))) {
+		cur_ = start;
+		_Throw("Invalid value");
+	}
+	if (integral) {
+		int64_t value = 0;
+		const auto result = std::from_chars(start, cur_, value);
+		if (result.ptr == cur_ && result.ec == std::errc()) {
+			if (value >= INT_MIN && value <= INT_MAX) {
+				item.type_ = ItemType::INTEGER;
+				item.value_ = static_cast<int>(value);
+				_CU_STATS_NODE(ItemType::INTEGER);
+			} else {
+				item.type_ = ItemType::LONG;
+				item.value_ = value;
+				_CU_STATS_NODE(ItemType::LONG);
+			}
+			return;
+		} else if (result.ec != std::errc::result_out_of_range) {
+			cur_ = start;
+			_Throw("Invalid number");
+		}
+	}
+	double value = 0.0;
+	const auto result = std::from_chars(start, cur_, value);
+	if (result.ptr != cur_ || (result.ec != std::errc() && result.ec != std::errc::result_out_of_range)) {
+		cur_ = start;
+		_Throw("Invalid number");
+	} else if (result.ec == std::errc::result_out_of_range) {
+		value = strtod(std::string(start, cur_).c_str(), nullptr);
+	}
+	item.type_ = ItemType::DOUBLE;
+	item.value_ = value;
+	_CU_STATS_NODE(ItemType::DOUBLE);
+}
+
+// Keeps a number in strict JSON syntax as text, typed from its digits the way _ParseNumber()
+// would convert it. Returns false for anything else, which is left to _ParseNumber().
+bool CU::JSONParser::_ParseRawNumber(JSONItem &item)
+{
+	const auto isDigit = [](const char &ch) noexcept {
+		return (ch >= '0' && ch <= '9');
+	};
+	const char* start = cur_;
+	const char* pos = cur_;
+	const bool negative = (pos != end_ && *pos == '-');
+	if (negative) {
+		pos++;
+	}
+	const char* digits = pos;
+	while (pos != end_ && isDigit(*pos)) {
+		pos++;
+	}
+	const auto count = static_cast<size_t>(pos - digits);
+	if (count == 0 || (count > 1 && *digits == '0')) {
+		return false;
+	}
+	bool integral = true;
+	if (pos != end_ && *pos == '.') {
+		integral = false;
+		const char* fraction = ++pos;
+		while (pos != end_ && isDigit(*pos)) {
+			pos++;
+		}
+		if (pos == fraction) {
+			return false;
+		}
+	}
+	if (pos != end_ && (*pos == 'e' || *pos == 'E')) {
+		integral = false;
+		pos++;
+		if (pos != end_ && (*pos == '+' || *pos == '-')) {
+			pos++;
+		}
+		const char* exponent = pos;
+		while (pos != end_ && isDigit(*pos)) {
+			pos++;
+		}
+		if (pos == exponent) {
+			return false;
+		}
+	}
+	// _ParseNumber() would take these into the token as well.
+	if (pos != end_ && (*pos == '.' || *pos == 'e' || *pos == 'E' || *pos == '+' || *pos == '-')) {
+		return false;
+	}
+	const auto size = static_cast<size_t>(pos - start);
+	if (size > sizeof(_RawNumber::text)) {
+		return false;
+	}
+	// Digits of the same count compare like the values.
+	const std::string_view magnitude(digits, count);
+	auto type = ItemType::DOUBLE;
+	if (!integral) {
+		// Fractions and exponents are always DOUBLE.
+	} else if (count < 10 || (count == 10 && magnitude <= (negative ? "2147483648" : "2147483647"))) {
+		type = ItemType::INTEGER;
+	} else if (count < 19 || (count == 19 && magnitude <= (negative ? "9223372036854775808" : "9223372036854775807"))) {
+		type = ItemType::LONG;
+	}
+	_RawNumber raw{};
+	memcpy(raw.text, start, size);
+	raw.size = static_cast<uint8_t>(size);
+	item.type_ = type;
+	item.value_ = raw;
+	_CU_STATS_NODE(type);
+	cur_ = pos;
+	return true;
+}
+
+void CU::JSONParser::_ParseLiteral(const char* literal, const size_t &length)
+{
+	if (static_cast<size_t>(end_ - cur_) < length || memcmp(cur_, literal, length) != 0) {
+		_Throw("Invalid value");
+	}
+	cur_ += length;
+}
+
+// Whether the value at cur_ is left out instead of being built.
+bool CU::JSONParser::_Skips(const _SchemaNode* schema)
+{
+	if (schema == nullptr) {
+		return false;
+	}
+	if (schema->skipScalars) {
+		_SkipSpace();
+		return (cur_ != end_ && *cur_ != '{' && *cur_ != '[');
+	}
+	return schema->ignore;
+}
+
+// Skips one value without building it: strings are only scanned for their closing quote
+// and containers are matched by counting brackets.
+void CU::JSONParser::_SkipValue()
+{
+	_SkipSpace();
+	size_t depth = 0;
+	do {
+		if (cur_ == end_) {
+			_Throw((depth == 0) ? "Value expected" : "Unterminated container");
+		}
+		switch (*cur_) {
+			case '\"':
+				_SkipString();
+				break;
+			case '{':
+			case '[':
+				depth++;
+				cur_++;
+				break;
+			case '}':
+			case ']':
+				if (depth == 0) {
+					_Throw("Value expected");
+				}
+				depth--;
+				cur_++;
+				break;
+			default:
+				{
+					const char* start = cur_;
+					while (cur_ != end_ && *cur_ != '\"' && *cur_ != '{' && *cur_ != '[' && *cur_ != '}' && *cur_ != ']' &&
+						(depth != 0 || (*cur_ != ',' && !_IsSpace(*cur_)))
+					) {
+						cur_++;
+					}
+					if (cur_ == start) {
+						_Throw("Value expected");
+					}
+				}
+				break;
+		}
+	} while (depth != 0);
+}
+
+void CU::JSONParser::_SkipString()
+{
+	cur_++;
+	for (;;) {
+		const auto quote = static_cast<const char*>(memchr(cur_, '\"', end_ - cur_));
+		if (quote == nullptr) {
+			cur_ = end_;
+			_Throw("Unterminated string");
+		}
+		size_t escapes = 0;
+		while (quote - escapes > cur_ && quote[-1 - static_cast<ptrdiff_t>(escapes)] == '\\') {
+			escapes++;
+		}
+		cur_ = quote + 1;
+		if (escapes % 2 == 0) {
+			return;
+		}
+	}
+}
+
+void CU::JSONParser::_SkipSpace() noexcept
+{
+	while (cur_ != end_ && _IsSpace(*cur_)) {
+		cur_++;
+	}
+}
+
+void CU::JSONParser::_Throw(const char* reason) const
+{
+	throw JSONExcept(std::string("Invalid JSON at offset ") + std::to_string(offset_ + (cur_ - begin_)) + ": " + reason);
+}
+
+void CU::JSONParser::_Reject(const std::string &reason) const
+{
+	throw JSONExcept(std::string("Schema violation at offset ") + std::to_string(offset_ + (cur_ - begin_)) + ": " + reason);
+}
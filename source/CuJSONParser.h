@@ -0,0 +1,164 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONPARSER_
+#define _CU_JSONPARSER_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	class JSONSchema;
+	class JSONProjection;
+	struct _SchemaNode;
+
+	// Owns a parsed value together with the pool its nodes, strings and containers are allocated from.
+	// Parsing into the same document again recycles the pool (and the root container when the
+	// new text has the same root type), so a warmed up document stops hitting the upstream heap.
+	class JSONDocument
+	{
+		public:
+			JSONDocument();
+			JSONDocument(std::pmr::memory_resource* upstream);
+			~JSONDocument();
+
+			JSONDocument(const JSONDocument &) = delete;
+			JSONDocument &operator=(const JSONDocument &) = delete;
+
+			JSONItem &root();
+			const JSONItem &root() const;
+			JSONArray &array();
+			JSONObject &object();
+			const JSONArray &array() const;
+			const JSONObject &object() const;
+			void clear();
+			std::pmr::memory_resource* resource();
+
+		private:
+			friend class JSONParser;
+
+			std::pmr::unsynchronized_pool_resource pool_;
+			JSONItem root_;
+	};
+
+	// Single pass parser. Keeps its scratch string and nesting stack between calls,
+	// one instance should be reused per thread. Throws JSONExcept on invalid input or
+	// when a limit is exceeded, leaving the target with the values parsed so far.
+	class JSONParser
+	{
+		public:
+			struct Options
+			{
+				size_t maxDepth;
+				size_t maxDocumentSize;
+				size_t maxStringLength;
+				size_t maxElements;
+				// Keeps the text of each number and converts it when toInt(), toLong() or
+				// toDouble() reads it; serializing writes the text back unchanged.
+				bool lazyNumbers;
+				// Strings without escapes are kept as views into the parsed text instead of
+				// being copied, so the text must outlive the values and stay unchanged;
+				// copying a value copies its strings. Escaped strings and keys are copied,
+				// and text given to feed() is always copied.
+				bool inSitu;
+
+				Options();
+			};
+
+			JSONParser();
+			JSONParser(const Options &options);
+			~JSONParser();
+
+			const Options &options() const;
+			void setOptions(const Options &options);
+
+			JSONParser(const JSONParser &) = delete;
+			JSONParser &operator=(const JSONParser &) = delete;
+
+			void parse(const std::string_view &text, JSONDocument &document);
+			void parse(const std::string_view &text, JSONArray &array);
+			void parse(const std::string_view &text, JSONObject &object);
+			void parse(const std::string_view &text, JSONItem &item);
+
+			// Validates against the schema while parsing and throws JSONExcept at the first
+			// violation. Members and items the schema ignores are skipped without being built;
+			// skipped text is only checked for terminated strings and balanced brackets.
+			void parse(const std::string_view &text, JSONArray &array, const JSONSchema &schema);
+			void parse(const std::string_view &text, JSONObject &object, const JSONSchema &schema);
+			void parse(const std::string_view &text, JSONItem &item, const JSONSchema &schema);
+
+			// Builds only the members selected by the projection and skips the others.
+			void parse(const std::string_view &text, JSONArray &array, const JSONProjection &projection);
+			void parse(const std::string_view &text, JSONObject &object, const JSONProjection &projection);
+			void parse(const std::string_view &text, JSONItem &item, const JSONProjection &projection);
+
+			// Incremental parsing for text that arrives in pieces split anywhere. Every
+			// feed() parses up to the last member or element separator seen so far and keeps
+			// only the unparsed tail; finish() parses the rest. The item is complete after
+			// finish() returns; after an exception, start again with begin().
+			void begin(JSONItem &item);
+			void feed(const std::string_view &chunk);
+			void finish();
+
+		private:
+			// seen is the offset of the object's required key flags in seen_.
+			struct _Frame
+			{
+				JSONArray* array;
+				JSONObject* object;
+				const _SchemaNode* schema;
+				size_t seen;
+				// Elements of an array, the ones the schema skips included.
+				size_t items;
+			};
+
+			Options options_;
+			const char* begin_;
+			const char* cur_;
+			const char* end_;
+			size_t elements_;
+			std::string scratch_;
+			std::vector<_Frame> stack_;
+			const _SchemaNode* schema_;
+			std::vector<uint8_t> seen_;
+			// Incremental state: the text not parsed yet, its offset in the whole text,
+			// how much of it the separator scan has seen, the scan's nesting state and
+			// where _NextItem() stopped.
+			JSONItem* target_;
+			std::string pending_;
+			size_t offset_;
+			size_t scanned_;
+			size_t scanDepth_;
+			bool inString_;
+			bool escaped_;
+			bool started_;
+			bool suspend_;
+			bool opened_;
+
+			void _Parse(const std::string_view &text, JSONArray &array, const _SchemaNode* schema);
+			void _Parse(const std::string_view &text, JSONObject &object, const _SchemaNode* schema);
+			void _Parse(const std::string_view &text, JSONItem &item, const _SchemaNode* schema);
+			void _Begin(const std::string_view &text);
+			void _Push(JSONArray* array, JSONObject* object);
+			void _Close(const _Frame &frame);
+			void _End();
+			void _Resume(const size_t &end);
+			void _ParseValues(JSONItem* item);
+			bool _ParseValue(JSONItem &item);
+			JSONItem* _NextItem(bool opened);
+			JSONItem* _ObjectItem(const _Frame &frame);
+			void _ParseString();
+			bool _ParseStringView(std::string_view &str);
+			void _ParseNumber(JSONItem &item);
+			bool _ParseRawNumber(JSONItem &item);
+			void _ParseLiteral(const char* literal, const size_t &length);
+			bool _Skips(const _SchemaNode* schema);
+			void _SkipValue();
+			void _SkipString();
+			void _SkipSpace() noexcept;
+			void _Throw(const char* reason) const;
+			void _Reject(const std::string &reason) const;
+	};
+}
+
+#endif // _CU_JSONPARSER_
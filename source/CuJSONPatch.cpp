@@ -0,0 +1,430 @@
+#include "CuJSONPatch.h"
+
+namespace CU
+{
+	namespace
+	{
+		bool _IsNumber(const JSONItem &item)
+		{
+			return (item.type() == ItemType::INTEGER || item.type() == ItemType::LONG || item.type() == ItemType::DOUBLE);
+		}
+
+		int64_t _IntegerValue(const JSONItem &item)
+		{
+			return (item.type() == ItemType::INTEGER) ? item.toInt() : item.toLong();
+		}
+
+		double _NumberValue(const JSONItem &item)
+		{
+			return (item.type() == ItemType::DOUBLE) ? item.toDouble() : static_cast<double>(_IntegerValue(item));
+		}
+
+		// Structural equality, object members compare regardless of their order. With byValue
+		// numbers of any type are equal when their values are (RFC 6902 4.6), the diff leaves
+		// it off so that applying a patch also restores the number types.
+		bool _Equal(const JSONItem &item, const JSONItem &other, const bool &byValue)
+		{
+			if (std::addressof(item) == std::addressof(other)) {
+				return true;
+			}
+			if (byValue && _IsNumber(item) && _IsNumber(other)) {
+				if (item.type() != ItemType::DOUBLE && other.type() != ItemType::DOUBLE) {
+					return (_IntegerValue(item) == _IntegerValue(other));
+				}
+				return (_NumberValue(item) == _NumberValue(other));
+			}
+			if (item.type() != other.type()) {
+				return false;
+			}
+			switch (item.type()) {
+				case ItemType::ARRAY:
+					{
+						const auto &array = item.asArray();
+						const auto &otherArray = other.asArray();
+						if (std::addressof(array) == std::addressof(otherArray)) {
+							return true;
+						}
+						if (array.size() != otherArray.size()) {
+							return false;
+						}
+						for (size_t pos = 0; pos < array.size(); pos++) {
+							if (!_Equal(*array.lookup(pos), *otherArray.lookup(pos), byValue)) {
+								return false;
+							}
+						}
+					}
+					return true;
+				case ItemType::OBJECT:
+					{
+						const auto &object = item.asObject();
+						const auto &otherObject = other.asObject();
+						if (std::addressof(object) == std::addressof(otherObject)) {
+							return true;
+						}
+						if (object.size() != otherObject.size()) {
+							return false;
+						}
+						for (const auto &[key, value] : object) {
+							auto otherValue = otherObject.lookup(key);
+							if (otherValue == nullptr || !_Equal(value, *otherValue, byValue)) {
+								return false;
+							}
+						}
+					}
+					return true;
+				default:
+					break;
+			}
+			return (item == other);
+		}
+
+		JSONObject _Operation(const char* op, const JSONPointer &path)
+		{
+			JSONObject operation{};
+			operation.add("op", op);
+			operation.add("path", path.toString());
+			return operation;
+		}
+
+		JSONObject _Operation(const char* op, const JSONPointer &path, const JSONItem &value)
+		{
+			auto operation = _Operation(op, path);
+			operation.add("value", value);
+			return operation;
+		}
+
+		void _Diff(const JSONItem &source, const JSONItem &target, const JSONPointer &path, JSONArray &patch);
+
+		void _DiffArray(const JSONArray &source, const JSONArray &target, const JSONPointer &path, JSONArray &patch)
+		{
+			if (std::addressof(source) == std::addressof(target)) {
+				return;
+			}
+			size_t prefix = 0;
+			while (prefix < source.size() && prefix < target.size() &&
+				_Equal(*source.lookup(prefix), *target.lookup(prefix), false)) {
+				prefix++;
+			}
+			size_t suffix = 0;
+			while (suffix < source.size() - prefix && suffix < target.size() - prefix &&
+				_Equal(*source.lookup(source.size() - suffix - 1), *target.lookup(target.size() - suffix - 1), false)) {
+				suffix++;
+			}
+			const auto sourceCount = source.size() - prefix - suffix;
+			const auto targetCount = target.size() - prefix - suffix;
+			const auto common = std::min(sourceCount, targetCount);
+			for (size_t pos = prefix; pos < prefix + common; pos++) {
+				_Diff(*source.lookup(pos), *target.lookup(pos), path.append(pos), patch);
+			}
+			// Removed from the back so the indexes of the earlier operations stay valid.
+			for (size_t pos = prefix + sourceCount; pos > prefix + common; pos--) {
+				patch.add(_Operation("remove", path.append(pos - 1)));
+			}
+			for (size_t pos = prefix + common; pos < prefix + targetCount; pos++) {
+				patch.add(_Operation("add", path.append(pos), *target.lookup(pos)));
+			}
+		}
+
+		void _DiffObject(const JSONObject &source, const JSONObject &target, const JSONPointer &path, JSONArray &patch)
+		{
+			if (std::addressof(source) == std::addressof(target)) {
+				return;
+			}
+			for (const auto &[key, value] : source) {
+				auto targetValue = target.lookup(key);
+				auto keyPath = path.append(std::string(key.data(), key.size()));
+				if (targetValue == nullptr) {
+					patch.add(_Operation("remove", keyPath));
+				} else {
+					_Diff(value, *targetValue, keyPath, patch);
+				}
+			}
+			for (const auto &[key, value] : target) {
+				if (source.lookup(key) == nullptr) {
+					patch.add(_Operation("add", path.append(std::string(key.data(), key.size())), value));
+				}
+			}
+		}
+
+		void _Diff(const JSONItem &source, const JSONItem &target, const JSONPointer &path, JSONArray &patch)
+		{
+			if (source.type() == target.type()) {
+				if (source.type() == ItemType::ARRAY) {
+					_DiffArray(source.asArray(), target.asArray(), path, patch);
+					return;
+				}
+				if (source.type() == ItemType::OBJECT) {
+					_DiffObject(source.asObject(), target.asObject(), path, patch);
+					return;
+				}
+				if (_Equal(source, target, false)) {
+					return;
+				}
+			}
+			patch.add(_Operation("replace", path, target));
+		}
+
+		const JSONItem &_Member(const JSONObject &operation, const char* name)
+		{
+			auto value = operation.lookup(name);
+			if (value == nullptr) {
+				throw JSONExcept(std::string("Patch operation without \"") + name + "\"");
+			}
+			return *value;
+		}
+
+		JSONPointer _MemberPointer(const JSONObject &operation, const char* name)
+		{
+			const auto &value = _Member(operation, name);
+			if (value.type() != ItemType::STRING) {
+				throw JSONExcept(std::string("Patch operation \"") + name + "\" is not a string");
+			}
+			return JSONPointer(value.toString());
+		}
+
+		// The container holding the last token of a pointer, resolved against one of the
+		// three root kinds. Only a JSONItem root can itself be the target of an operation.
+		struct _Parent
+		{
+			JSONArray* array;
+			JSONObject* object;
+		};
+
+		_Parent _ParentItem(JSONItem* item)
+		{
+			if (item != nullptr) {
+				if (item->type() == ItemType::ARRAY) {
+					return _Parent{std::addressof(item->asArray()), nullptr};
+				}
+				if (item->type() == ItemType::OBJECT) {
+					return _Parent{nullptr, std::addressof(item->asObject())};
+				}
+			}
+			throw JSONExcept("Patch path parent not found");
+		}
+
+		_Parent _ParentOf(JSONItem &root, const JSONPointer &path)
+		{
+			return _ParentItem(path.parent().find(root));
+		}
+
+		_Parent _ParentOf(JSONArray &root, const JSONPointer &path)
+		{
+			if (path.size() == 1) {
+				return _Parent{std::addressof(root), nullptr};
+			}
+			return _ParentItem(path.parent().find(root));
+		}
+
+		_Parent _ParentOf(JSONObject &root, const JSONPointer &path)
+		{
+			if (path.size() == 1) {
+				return _Parent{nullptr, std::addressof(root)};
+			}
+			return _ParentItem(path.parent().find(root));
+		}
+
+		void _ReplaceRoot(JSONItem &root, const JSONItem &value)
+		{
+			root = value;
+		}
+
+		void _ReplaceRoot(JSONArray &root, const JSONItem &value)
+		{
+			root = value.asArray();
+		}
+
+		void _ReplaceRoot(JSONObject &root, const JSONItem &value)
+		{
+			root = value.asObject();
+		}
+
+		template <typename _Root>
+		JSONItem &_Get(_Root &root, const JSONPointer &path)
+		{
+			auto item = path.find(root);
+			if (item == nullptr) {
+				throw JSONExcept("Patch path not found: " + path.toString());
+			}
+			return *item;
+		}
+
+		template <typename _Root>
+		void _Add(_Root &root, const JSONPointer &path, const JSONItem &value)
+		{
+			if (path.empty()) {
+				_ReplaceRoot(root, value);
+				return;
+			}
+			auto parent = _ParentOf(root, path);
+			const auto &token = path.token(path.size() - 1);
+			if (parent.object != nullptr) {
+				parent.object->add(token, value);
+			} else if (token == "-") {
+				parent.array->add(value);
+			} else {
+				const auto index = path.index(path.size() - 1);
+				if (index == JSONPointer::npos || index > parent.array->size()) {
+					throw JSONExcept("Patch index out of bound: " + path.toString());
+				}
+				parent.array->insert(index, value);
+			}
+		}
+
+		template <typename _Root>
+		void _Remove(_Root &root, const JSONPointer &path)
+		{
+			if (path.empty()) {
+				throw JSONExcept("Patch cannot remove the root");
+			}
+			auto parent = _ParentOf(root, path);
+			const auto &token = path.token(path.size() - 1);
+			if (parent.object != nullptr) {
+				if (parent.object->lookup(token) == nullptr) {
+					throw JSONExcept("Patch path not found: " + path.toString());
+				}
+				parent.object->remove(token);
+			} else {
+				const auto index = path.index(path.size() - 1);
+				if (index == JSONPointer::npos || index >= parent.array->size()) {
+					throw JSONExcept("Patch index out of bound: " + path.toString());
+				}
+				parent.array->erase(index);
+			}
+		}
+
+		template <typename _Root>
+		void _Apply(_Root &root, const JSONArray &patch)
+		{
+			for (const auto &item : patch) {
+				const auto &operation = item.asObject();
+				const auto &op = _Member(operation, "op");
+				const auto opName = op.toString();
+				const auto path = _MemberPointer(operation, "path");
+				if (opName == "add") {
+					_Add(root, path, _Member(operation, "value"));
+				} else if (opName == "remove") {
+					_Remove(root, path);
+				} else if (opName == "replace") {
+					if (path.empty()) {
+						_ReplaceRoot(root, _Member(operation, "value"));
+					} else {
+						_Get(root, path) = _Member(operation, "value");
+					}
+				} else if (opName == "move") {
+					const auto from = _MemberPointer(operation, "from");
+					if (from == path) {
+						_Get(root, from);
+						continue;
+					}
+					if (from.size() < path.size()) {
+						auto prefix = path;
+						while (prefix.size() > from.size()) {
+							prefix = prefix.parent();
+						}
+						if (prefix == from) {
+							throw JSONExcept("Patch cannot move a value into itself");
+						}
+					}
+					JSONItem value(_Get(root, from));
+					_Remove(root, from);
+					_Add(root, path, value);
+				} else if (opName == "copy") {
+					JSONItem value(_Get(root, _MemberPointer(operation, "from")));
+					_Add(root, path, value);
+				} else if (opName == "test") {
+					if (!_Equal(_Get(root, path), _Member(operation, "value"), true)) {
+						throw JSONExcept("Patch test failed: " + path.toString());
+					}
+				} else {
+					throw JSONExcept("Unknown patch operation: " + opName);
+				}
+			}
+		}
+
+		void _MergeObject(JSONObject &document, const JSONObject &patch);
+
+		// MergePatch({}, value) of RFC 7386, so nulls nested in added objects are dropped as well.
+		JSONItem _MergeValue(const JSONItem &patch)
+		{
+			if (patch.type() != ItemType::OBJECT) {
+				return patch;
+			}
+			JSONObject object{};
+			_MergeObject(object, patch.asObject());
+			return object;
+		}
+
+		void _MergeObject(JSONObject &document, const JSONObject &patch)
+		{
+			if (std::addressof(document) == std::addressof(patch)) {
+				return;
+			}
+			for (const auto &[key, value] : patch) {
+				auto current = document.lookup(key);
+				if (value.type() == ItemType::ITEM_NULL) {
+					if (current != nullptr) {
+						document.remove(std::string(key.data(), key.size()));
+					}
+				} else if (value.type() == ItemType::OBJECT && current != nullptr && current->type() == ItemType::OBJECT) {
+					_MergeObject(current->asObject(), value.asObject());
+				} else {
+					document.add(std::string(key.data(), key.size()), _MergeValue(value));
+				}
+			}
+		}
+	}
+}
+
+CU::JSONArray CU::CreatePatch(const JSONItem &source, const JSONItem &target)
+{
+	JSONArray patch{};
+	_Diff(source, target, JSONPointer(), patch);
+	return patch;
+}
+
+CU::JSONArray CU::CreatePatch(const JSONArray &source, const JSONArray &target)
+{
+	JSONArray patch{};
+	_DiffArray(source, target, JSONPointer(), patch);
+	return patch;
+}
+
+CU::JSONArray CU::CreatePatch(const JSONObject &source, const JSONObject &target)
+{
+	JSONArray patch{};
+	_DiffObject(source, target, JSONPointer(), patch);
+	return patch;
+}
+
+void CU::ApplyPatch(JSONItem &document, const JSONArray &patch)
+{
+	_Apply(document, patch);
+}
+
+void CU::ApplyPatch(JSONArray &document, const JSONArray &patch)
+{
+	_Apply(document, patch);
+}
+
+void CU::ApplyPatch(JSONObject &document, const JSONArray &patch)
+{
+	_Apply(document, patch);
+}
+
+void CU::ApplyMergePatch(JSONItem &document, const JSONItem &patch)
+{
+	if (patch.type() != ItemType::OBJECT) {
+		document = patch;
+		return;
+	}
+	if (document.type() != ItemType::OBJECT) {
+		document = JSONObject();
+	}
+	_MergeObject(document.asObject(), patch.asObject());
+}
+
+void CU::ApplyMergePatch(JSONObject &document, const JSONObject &patch)
+{
+	_MergeObject(document, patch);
+}
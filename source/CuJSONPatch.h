@@ -0,0 +1,32 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONPATCH_
+#define _CU_JSONPATCH_
+
+#include "CuJSONObject.h"
+#include "CuJSONPointer.h"
+
+namespace CU
+{
+	// RFC 6902 JSON Patch turning source into target. Equal subtrees produce no
+	// operations, arrays only emit operations for the span between their common
+	// prefix and suffix, so a small change gives a small patch.
+	JSONArray CreatePatch(const JSONItem &source, const JSONItem &target);
+	JSONArray CreatePatch(const JSONArray &source, const JSONArray &target);
+	JSONArray CreatePatch(const JSONObject &source, const JSONObject &target);
+
+	// Applies the operations in order and throws JSONExcept on the first one that
+	// fails, leaving the operations before it applied; patch a copy when the
+	// update has to be atomic.
+	void ApplyPatch(JSONItem &document, const JSONArray &patch);
+	void ApplyPatch(JSONArray &document, const JSONArray &patch);
+	void ApplyPatch(JSONObject &document, const JSONArray &patch);
+
+	// RFC 7386 JSON Merge Patch: null members remove keys, objects merge
+	// recursively and every other value replaces the target member.
+	void ApplyMergePatch(JSONItem &document, const JSONItem &patch);
+	void ApplyMergePatch(JSONObject &document, const JSONObject &patch);
+}
+
+#endif // _CU_JSONPATCH_
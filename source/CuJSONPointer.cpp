@@ -0,0 +1,675 @@
+#include "CuJSONPointer.h"
+#include "CuJSONInternal.h"
+#include <charconv>
+#include <cstring>
+#include <forward_list>
+
+namespace CU
+{
+	namespace
+	{
+		// Array indexes follow RFC 6901: decimal digits without leading zeros.
+		size_t _ToIndex(const std::string_view &token) noexcept
+		{
+			if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+				return JSONPointer::npos;
+			}
+			size_t index = 0;
+			auto result = std::from_chars(token.data(), token.data() + token.size(), index);
+			if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+				return JSONPointer::npos;
+			}
+			return index;
+		}
+
+		template <typename _Object>
+		auto _ObjectChild(_Object &object, const _PathStep &step) -> decltype(object.lookup(step.key))
+		{
+			if (step.type == _PathStepType::INDEX) {
+				return nullptr;
+			}
+			return object.lookup(step.key);
+		}
+
+		template <typename _Array>
+		auto _ArrayChild(_Array &array, const _PathStep &step) -> decltype(array.lookup(step.index))
+		{
+			if (step.type == _PathStepType::KEY || step.index == JSONPointer::npos) {
+				return nullptr;
+			}
+			return array.lookup(step.index);
+		}
+
+		template <typename _Item>
+		_Item* _ItemChild(_Item &item, const _PathStep &step)
+		{
+			switch (item.type()) {
+				case ItemType::OBJECT:
+					return _ObjectChild(item.asObject(), step);
+				case ItemType::ARRAY:
+					return _ArrayChild(item.asArray(), step);
+				default:
+					break;
+			}
+			return nullptr;
+		}
+
+		template <typename _Item>
+		_Item* _Walk(_Item* item, const std::vector<_PathStep> &steps, const size_t &first)
+		{
+			for (size_t pos = first; pos < steps.size() && item != nullptr; pos++) {
+				item = _ItemChild(*item, steps[pos]);
+			}
+			return item;
+		}
+
+		// Recursion is bounded by the number of steps, not by the document depth.
+		bool _Select(const JSONItem &item, const std::vector<_PathStep> &steps, const size_t &pos,
+			std::vector<const JSONItem*> &results, const bool &single);
+
+		bool _SelectChildren(const JSONArray &array, const std::vector<_PathStep> &steps, const size_t &pos,
+			std::vector<const JSONItem*> &results, const bool &single)
+		{
+			const auto &step = steps[pos];
+			if (step.type != _PathStepType::WILDCARD) {
+				auto child = _ArrayChild(array, step);
+				return (child != nullptr && _Select(*child, steps, pos + 1, results, single));
+			}
+			for (const auto &child : array) {
+				if (_Select(child, steps, pos + 1, results, single)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool _SelectChildren(const JSONObject &object, const std::vector<_PathStep> &steps, const size_t &pos,
+			std::vector<const JSONItem*> &results, const bool &single)
+		{
+			const auto &step = steps[pos];
+			if (step.type != _PathStepType::WILDCARD) {
+				auto child = _ObjectChild(object, step);
+				return (child != nullptr && _Select(*child, steps, pos + 1, results, single));
+			}
+			for (const auto &entry : object) {
+				if (_Select(entry.second, steps, pos + 1, results, single)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool _Select(const JSONItem &item, const std::vector<_PathStep> &steps, const size_t &pos,
+			std::vector<const JSONItem*> &results, const bool &single)
+		{
+			if (pos == steps.size()) {
+				results.emplace_back(std::addressof(item));
+				return single;
+			}
+			switch (item.type()) {
+				case ItemType::OBJECT:
+					return _SelectChildren(item.asObject(), steps, pos, results, single);
+				case ItemType::ARRAY:
+					return _SelectChildren(item.asArray(), steps, pos, results, single);
+				default:
+					break;
+			}
+			return false;
+		}
+
+		// Walks the raw text without building a tree. Only the containers on the path are
+		// entered, every other value is skipped by bracket matching and is not validated;
+		// the matched values are handed back as slices for the parser to materialize.
+		// Duplicated keys resolve like the parser: first position, last value.
+		class _RawScanner
+		{
+			public:
+				_RawScanner(const std::string_view &text) : begin_(text.data()), cur_(text.data()), end_(text.data() + text.size()) { }
+
+				bool select(const std::vector<_PathStep> &steps, const size_t &pos,
+					std::vector<std::string_view> &results, const bool &single)
+				{
+					_SkipSpace();
+					if (cur_ == end_) {
+						_Throw("Unexpected end of input");
+					}
+					if (pos == steps.size()) {
+						auto valueBegin = cur_;
+						_SkipValue();
+						results.emplace_back(valueBegin, static_cast<size_t>(cur_ - valueBegin));
+						return single;
+					}
+					const auto &step = steps[pos];
+					if (*cur_ == '{' && step.type != _PathStepType::INDEX) {
+						return _SelectMembers(steps, pos, results, single);
+					}
+					if (*cur_ == '[' && step.type != _PathStepType::KEY) {
+						return _SelectElements(steps, pos, results, single);
+					}
+					_SkipValue();
+					return false;
+				}
+
+			private:
+				const char* begin_;
+				const char* cur_;
+				const char* end_;
+
+				bool _SelectMembers(const std::vector<_PathStep> &steps, const size_t &pos,
+					std::vector<std::string_view> &results, const bool &single)
+				{
+					const auto &step = steps[pos];
+					cur_++;
+					_SkipSpace();
+					if (cur_ != end_ && *cur_ == '}') {
+						cur_++;
+						return false;
+					}
+					// Matches are entered once the object has been scanned, a later duplicate
+					// replaces the value of an earlier one.
+					std::vector<const char*> matches{};
+					std::unordered_map<std::string_view, size_t> seen{};
+					std::forward_list<std::string> decoded{};
+					for (;;) {
+						_SkipSpace();
+						if (cur_ == end_ || *cur_ != '\"') {
+							_Throw("Expected object key");
+						}
+						auto keyBegin = cur_;
+						_SkipString();
+						auto key = std::string_view(keyBegin, static_cast<size_t>(cur_ - keyBegin));
+						_SkipSpace();
+						if (cur_ == end_ || *cur_ != ':') {
+							_Throw("Expected ':'");
+						}
+						cur_++;
+						_SkipSpace();
+						if (step.type == _PathStepType::WILDCARD) {
+							auto name = key.substr(1, key.size() - 2);
+							if (name.find('\\') != std::string_view::npos) {
+								JSONItem item{};
+								_ThreadParser().parse(key, item);
+								name = decoded.emplace_front(item.toString());
+							}
+							auto result = seen.emplace(name, matches.size());
+							if (result.second) {
+								matches.emplace_back(cur_);
+							} else {
+								matches[result.first->second] = cur_;
+							}
+						} else if (_KeyMatches(key, step.key)) {
+							matches.assign(1, cur_);
+						}
+						_SkipValue();
+						_SkipSpace();
+						if (cur_ != end_ && *cur_ == ',') {
+							cur_++;
+						} else if (cur_ != end_ && *cur_ == '}') {
+							cur_++;
+							break;
+						} else {
+							_Throw("Expected ',' or '}'");
+						}
+					}
+					const auto after = cur_;
+					for (const auto &match : matches) {
+						cur_ = match;
+						if (select(steps, pos + 1, results, single)) {
+							return true;
+						}
+					}
+					cur_ = after;
+					return false;
+				}
+
+				bool _SelectElements(const std::vector<_PathStep> &steps, const size_t &pos,
+					std::vector<std::string_view> &results, const bool &single)
+				{
+					const auto &step = steps[pos];
+					cur_++;
+					_SkipSpace();
+					if (cur_ != end_ && *cur_ == ']') {
+						cur_++;
+						return false;
+					}
+					for (size_t index = 0; ; index++) {
+						if (step.type == _PathStepType::WILDCARD || index == step.index) {
+							if (select(steps, pos + 1, results, single)) {
+								return true;
+							}
+						} else {
+							_SkipValue();
+						}
+						_SkipSpace();
+						if (cur_ != end_ && *cur_ == ',') {
+							cur_++;
+						} else if (cur_ != end_ && *cur_ == ']') {
+							cur_++;
+							return false;
+						} else {
+							_Throw("Expected ',' or ']'");
+						}
+					}
+				}
+
+				// Keys without escapes are compared in place, the rest go through the parser.
+				bool _KeyMatches(const std::string_view &quoted, const std::string &key) const
+				{
+					auto raw = quoted.substr(1, quoted.size() - 2);
+					if (raw.find('\\') == std::string_view::npos) {
+						return (raw == key);
+					}
+					JSONItem decoded{};
+					_ThreadParser().parse(quoted, decoded);
+					return (decoded.toString() == key);
+				}
+
+				void _SkipSpace() noexcept
+				{
+					while (cur_ != end_ && _IsSpace(*cur_)) {
+						cur_++;
+					}
+				}
+
+				void _SkipString()
+				{
+					auto strBegin = ++cur_;
+					for (;;) {
+						auto quote = static_cast<const char*>(std::memchr(cur_, '\"', static_cast<size_t>(end_ - cur_)));
+						if (quote == nullptr) {
+							cur_ = end_;
+							_Throw("Unterminated string");
+						}
+						auto escape = quote;
+						while (escape != strBegin && *(escape - 1) == '\\') {
+							escape--;
+						}
+						cur_ = quote + 1;
+						if (((quote - escape) & 1) == 0) {
+							return;
+						}
+					}
+				}
+
+				void _SkipValue()
+				{
+					_SkipSpace();
+					if (cur_ == end_) {
+						_Throw("Unexpected end of input");
+					}
+					if (*cur_ == '\"') {
+						_SkipString();
+						return;
+					}
+					if (*cur_ == '{' || *cur_ == '[') {
+						size_t depth = 0;
+						while (cur_ != end_) {
+							switch (*cur_) {
+								case '\"':
+									_SkipString();
+									continue;
+								case '{':
+								case '[':
+									depth++;
+									break;
+								case '}':
+								case ']':
+									depth--;
+									if (depth == 0) {
+										cur_++;
+										return;
+									}
+									break;
+								default:
+									break;
+							}
+							cur_++;
+						}
+						_Throw("Unterminated container");
+					}
+					auto valueBegin = cur_;
+					while (cur_ != end_ && *cur_ != ',' && *cur_ != '}' && *cur_ != ']' && !_IsSpace(*cur_)) {
+						cur_++;
+					}
+					if (cur_ == valueBegin) {
+						_Throw("Invalid value");
+					}
+				}
+
+				void _Throw(const char* reason) const
+				{
+					throw JSONExcept(std::string("Invalid JSON at offset ") + std::to_string(cur_ - begin_) + ": " + reason);
+				}
+		};
+
+		std::string _EscapeToken(const std::string &token)
+		{
+			std::string escaped{};
+			escaped.reserve(token.size());
+			for (const auto &ch : token) {
+				if (ch == '~') {
+					escaped += "~0";
+				} else if (ch == '/') {
+					escaped += "~1";
+				} else {
+					escaped += ch;
+				}
+			}
+			return escaped;
+		}
+
+		_PathStep _PointerStep(const std::string &key)
+		{
+			return _PathStep{_PathStepType::KEY_OR_INDEX, key, _ToIndex(key)};
+		}
+	}
+}
+
+CU::JSONPointer::JSONPointer() : steps_() { }
+
+CU::JSONPointer::JSONPointer(const std::string &pointer) : steps_()
+{
+	if (pointer.empty()) {
+		return;
+	}
+	if (pointer[0] != '/') {
+		throw JSONExcept("Invalid JSON pointer");
+	}
+	std::string token{};
+	for (size_t pos = 1; pos <= pointer.size(); pos++) {
+		if (pos == pointer.size() || pointer[pos] == '/') {
+			steps_.emplace_back(_PointerStep(token));
+			token.clear();
+		} else if (pointer[pos] == '~') {
+			pos++;
+			if (pos == pointer.size() || (pointer[pos] != '0' && pointer[pos] != '1')) {
+				throw JSONExcept("Invalid JSON pointer");
+			}
+			token += (pointer[pos] == '0') ? '~' : '/';
+		} else {
+			token += pointer[pos];
+		}
+	}
+}
+
+CU::JSONPointer::JSONPointer(const std::vector<std::string> &keys) : steps_()
+{
+	steps_.reserve(keys.size());
+	for (const auto &key : keys) {
+		steps_.emplace_back(_PointerStep(key));
+	}
+}
+
+bool CU::JSONPointer::operator==(const JSONPointer &other) const
+{
+	if (steps_.size() != other.steps_.size()) {
+		return false;
+	}
+	for (size_t pos = 0; pos < steps_.size(); pos++) {
+		if (steps_[pos].key != other.steps_[pos].key) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CU::JSONPointer::operator!=(const JSONPointer &other) const
+{
+	return !(*this == other);
+}
+
+const CU::JSONItem* CU::JSONPointer::find(const JSONItem &root) const
+{
+	return _Walk(std::addressof(root), steps_, 0);
+}
+
+const CU::JSONItem* CU::JSONPointer::find(const JSONArray &root) const
+{
+	if (steps_.empty()) {
+		return nullptr;
+	}
+	return _Walk(_ArrayChild(root, steps_[0]), steps_, 1);
+}
+
+const CU::JSONItem* CU::JSONPointer::find(const JSONObject &root) const
+{
+	if (steps_.empty()) {
+		return nullptr;
+	}
+	return _Walk(_ObjectChild(root, steps_[0]), steps_, 1);
+}
+
+CU::JSONItem* CU::JSONPointer::find(JSONItem &root) const
+{
+	return _Walk(std::addressof(root), steps_, 0);
+}
+
+CU::JSONItem* CU::JSONPointer::find(JSONArray &root) const
+{
+	if (steps_.empty()) {
+		return nullptr;
+	}
+	return _Walk(_ArrayChild(root, steps_[0]), steps_, 1);
+}
+
+CU::JSONItem* CU::JSONPointer::find(JSONObject &root) const
+{
+	if (steps_.empty()) {
+		return nullptr;
+	}
+	return _Walk(_ObjectChild(root, steps_[0]), steps_, 1);
+}
+
+bool CU::JSONPointer::extract(const std::string_view &JSONText, JSONItem &item) const
+{
+	std::vector<std::string_view> results{};
+	_RawScanner(JSONText).select(steps_, 0, results, true);
+	if (results.empty()) {
+		return false;
+	}
+	_ThreadParser().parse(results.front(), item);
+	return true;
+}
+
+CU::JSONPointer CU::JSONPointer::parent() const
+{
+	JSONPointer pointer{};
+	if (!steps_.empty()) {
+		pointer.steps_.assign(steps_.begin(), steps_.end() - 1);
+	}
+	return pointer;
+}
+
+CU::JSONPointer CU::JSONPointer::append(const std::string &key) const
+{
+	JSONPointer pointer(*this);
+	pointer.steps_.emplace_back(_PointerStep(key));
+	return pointer;
+}
+
+CU::JSONPointer CU::JSONPointer::append(const size_t &index) const
+{
+	return append(std::to_string(index));
+}
+
+const std::string &CU::JSONPointer::token(const size_t &pos) const
+{
+	if (pos >= steps_.size()) {
+		throw JSONExcept("Position out of bound");
+	}
+	return steps_[pos].key;
+}
+
+size_t CU::JSONPointer::index(const size_t &pos) const
+{
+	if (pos >= steps_.size()) {
+		throw JSONExcept("Position out of bound");
+	}
+	return steps_[pos].index;
+}
+
+size_t CU::JSONPointer::size() const
+{
+	return steps_.size();
+}
+
+bool CU::JSONPointer::empty() const
+{
+	return steps_.empty();
+}
+
+std::string CU::JSONPointer::toString() const
+{
+	std::string pointer{};
+	for (const auto &step : steps_) {
+		pointer += '/';
+		pointer += _EscapeToken(step.key);
+	}
+	return pointer;
+}
+
+CU::JSONPath::JSONPath(const std::string &path) : path_(path), steps_()
+{
+	if (path.empty() || path[0] != '$') {
+		throw JSONExcept("Invalid JSONPath");
+	}
+	size_t pos = 1;
+	while (pos < path.size()) {
+		if (path[pos] == '.') {
+			pos++;
+			if (pos < path.size() && path[pos] == '.') {
+				throw JSONExcept("Unsupported JSONPath");
+			}
+			if (pos < path.size() && path[pos] == '*') {
+				steps_.emplace_back(_PathStep{_PathStepType::WILDCARD, std::string(), JSONPointer::npos});
+				pos++;
+				continue;
+			}
+			auto nameEnd = path.find_first_of(".[", pos);
+			if (nameEnd == std::string::npos) {
+				nameEnd = path.size();
+			}
+			if (nameEnd == pos) {
+				throw JSONExcept("Invalid JSONPath");
+			}
+			steps_.emplace_back(_PathStep{_PathStepType::KEY, path.substr(pos, nameEnd - pos), JSONPointer::npos});
+			pos = nameEnd;
+		} else if (path[pos] == '[') {
+			pos++;
+			if (pos == path.size()) {
+				throw JSONExcept("Invalid JSONPath");
+			}
+			if (path[pos] == '*') {
+				steps_.emplace_back(_PathStep{_PathStepType::WILDCARD, std::string(), JSONPointer::npos});
+				pos++;
+			} else if (path[pos] == '\'' || path[pos] == '\"') {
+				const auto quote = path[pos++];
+				std::string key{};
+				while (pos < path.size() && path[pos] != quote) {
+					if (path[pos] == '\\' && pos + 1 < path.size()) {
+						pos++;
+					}
+					key += path[pos++];
+				}
+				if (pos == path.size()) {
+					throw JSONExcept("Invalid JSONPath");
+				}
+				pos++;
+				steps_.emplace_back(_PathStep{_PathStepType::KEY, key, JSONPointer::npos});
+			} else {
+				auto indexEnd = path.find(']', pos);
+				if (indexEnd == std::string::npos) {
+					throw JSONExcept("Invalid JSONPath");
+				}
+				auto index = _ToIndex(std::string_view(path).substr(pos, indexEnd - pos));
+				if (index == JSONPointer::npos) {
+					throw JSONExcept("Invalid JSONPath");
+				}
+				steps_.emplace_back(_PathStep{_PathStepType::INDEX, std::string(), index});
+				pos = indexEnd;
+			}
+			if (pos == path.size() || path[pos] != ']') {
+				throw JSONExcept("Invalid JSONPath");
+			}
+			pos++;
+		} else {
+			throw JSONExcept("Invalid JSONPath");
+		}
+	}
+}
+
+std::vector<const CU::JSONItem*> CU::JSONPath::select(const JSONItem &root) const
+{
+	std::vector<const JSONItem*> results{};
+	_Select(root, steps_, 0, results, definite());
+	return results;
+}
+
+std::vector<const CU::JSONItem*> CU::JSONPath::select(const JSONArray &root) const
+{
+	std::vector<const JSONItem*> results{};
+	if (!steps_.empty()) {
+		_SelectChildren(root, steps_, 0, results, definite());
+	}
+	return results;
+}
+
+std::vector<const CU::JSONItem*> CU::JSONPath::select(const JSONObject &root) const
+{
+	std::vector<const JSONItem*> results{};
+	if (!steps_.empty()) {
+		_SelectChildren(root, steps_, 0, results, definite());
+	}
+	return results;
+}
+
+const CU::JSONItem* CU::JSONPath::first(const JSONItem &root) const
+{
+	std::vector<const JSONItem*> results{};
+	_Select(root, steps_, 0, results, true);
+	return results.empty() ? nullptr : results.front();
+}
+
+const CU::JSONItem* CU::JSONPath::first(const JSONArray &root) const
+{
+	std::vector<const JSONItem*> results{};
+	if (!steps_.empty()) {
+		_SelectChildren(root, steps_, 0, results, true);
+	}
+	return results.empty() ? nullptr : results.front();
+}
+
+const CU::JSONItem* CU::JSONPath::first(const JSONObject &root) const
+{
+	std::vector<const JSONItem*> results{};
+	if (!steps_.empty()) {
+		_SelectChildren(root, steps_, 0, results, true);
+	}
+	return results.empty() ? nullptr : results.front();
+}
+
+std::vector<CU::JSONItem> CU::JSONPath::extract(const std::string_view &JSONText) const
+{
+	std::vector<std::string_view> slices{};
+	_RawScanner(JSONText).select(steps_, 0, slices, definite());
+	std::vector<JSONItem> results(slices.size());
+	for (size_t pos = 0; pos < slices.size(); pos++) {
+		_ThreadParser().parse(slices[pos], results[pos]);
+	}
+	return results;
+}
+
+bool CU::JSONPath::definite() const
+{
+	for (const auto &step : steps_) {
+		if (step.type == _PathStepType::WILDCARD) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string CU::JSONPath::toString() const
+{
+	return path_;
+}
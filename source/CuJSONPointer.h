@@ -0,0 +1,81 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONPOINTER_
+#define _CU_JSONPOINTER_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	enum class _PathStepType : uint8_t {KEY, INDEX, KEY_OR_INDEX, WILDCARD};
+
+	struct _PathStep
+	{
+		_PathStepType type;
+		std::string key;
+		size_t index;
+	};
+
+	// RFC 6901 pointer ("/a/b/3"), compiled once and evaluated by reference.
+	// find() returns nullptr when the target does not exist; the empty pointer
+	// refers to the root, which only a JSONItem root can hand back.
+	class JSONPointer
+	{
+		public:
+			static constexpr size_t npos = static_cast<size_t>(-1);
+
+			JSONPointer();
+			JSONPointer(const std::string &pointer);
+			JSONPointer(const std::vector<std::string> &keys);
+
+			bool operator==(const JSONPointer &other) const;
+			bool operator!=(const JSONPointer &other) const;
+
+			const JSONItem* find(const JSONItem &root) const;
+			const JSONItem* find(const JSONArray &root) const;
+			const JSONItem* find(const JSONObject &root) const;
+			JSONItem* find(JSONItem &root) const;
+			JSONItem* find(JSONArray &root) const;
+			JSONItem* find(JSONObject &root) const;
+			bool extract(const std::string_view &JSONText, JSONItem &item) const;
+
+			JSONPointer parent() const;
+			JSONPointer append(const std::string &key) const;
+			JSONPointer append(const size_t &index) const;
+			const std::string &token(const size_t &pos) const;
+			size_t index(const size_t &pos) const;
+			size_t size() const;
+			bool empty() const;
+			std::string toString() const;
+
+		private:
+			std::vector<_PathStep> steps_;
+	};
+
+	// JSONPath subset: $, .name, ['name'], [3], [*] and .*
+	// select() walks the tree by reference, extract() scans the raw text and
+	// only materializes the matched values.
+	class JSONPath
+	{
+		public:
+			JSONPath(const std::string &path);
+
+			std::vector<const JSONItem*> select(const JSONItem &root) const;
+			std::vector<const JSONItem*> select(const JSONArray &root) const;
+			std::vector<const JSONItem*> select(const JSONObject &root) const;
+			const JSONItem* first(const JSONItem &root) const;
+			const JSONItem* first(const JSONArray &root) const;
+			const JSONItem* first(const JSONObject &root) const;
+			std::vector<JSONItem> extract(const std::string_view &JSONText) const;
+
+			bool definite() const;
+			std::string toString() const;
+
+		private:
+			std::string path_;
+			std::vector<_PathStep> steps_;
+	};
+}
+
+#endif // _CU_JSONPOINTER_
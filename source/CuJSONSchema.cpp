@@ -0,0 +1,334 @@
+#include "CuJSONSchema.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CU
+{
+	namespace
+	{
+		uint8_t _TypeBit(const JSONItem &name)
+		{
+			if (name.type() == ItemType::STRING) {
+				const auto type = name.asString();
+				if (type == "null") {
+					return _SchemaNull;
+				} else if (type == "boolean") {
+					return _SchemaBoolean;
+				} else if (type == "integer") {
+					return _SchemaInteger;
+				} else if (type == "number") {
+					return _SchemaNumber;
+				} else if (type == "string") {
+					return _SchemaString;
+				} else if (type == "array") {
+					return _SchemaArray;
+				} else if (type == "object") {
+					return _SchemaObject;
+				}
+			}
+			throw JSONExcept("Invalid schema: unknown type");
+		}
+
+		// The conversions of JSONItem are strict, numbers of any width are read here.
+		double _NumberValue(const JSONItem &value) noexcept
+		{
+			switch (value.type()) {
+				case ItemType::INTEGER:
+					return value.toInt();
+				case ItemType::LONG:
+					return static_cast<double>(value.toLong());
+				default:
+					break;
+			}
+			return value.toDouble();
+		}
+
+		double _Number(const JSONItem &value, const char* keyword)
+		{
+			switch (value.type()) {
+				case ItemType::INTEGER:
+				case ItemType::LONG:
+				case ItemType::DOUBLE:
+					return _NumberValue(value);
+				default:
+					break;
+			}
+			throw JSONExcept(std::string("Invalid schema: ") + keyword + " must be a number");
+		}
+
+		size_t _Count(const JSONItem &value, const char* keyword)
+		{
+			if (value.type() == ItemType::INTEGER && value.toInt() >= 0) {
+				return static_cast<size_t>(value.toInt());
+			} else if (value.type() == ItemType::LONG && value.toLong() >= 0) {
+				return static_cast<size_t>(value.toLong());
+			}
+			throw JSONExcept(std::string("Invalid schema: ") + keyword + " must be a non-negative integer");
+		}
+
+		template <typename _Properties>
+		auto _LowerBound(_Properties &properties, const std::string_view &key)
+		{
+			return std::lower_bound(properties.begin(), properties.end(), key,
+				[](const _SchemaProperty &property, const std::string_view &key) { return (property.key < key); });
+		}
+
+		const JSONObject &_Object(const JSONItem &value, const char* keyword)
+		{
+			if (value.type() != ItemType::OBJECT) {
+				throw JSONExcept(std::string("Invalid schema: ") + keyword + " must be an object");
+			}
+			return value.asObject();
+		}
+	}
+}
+
+CU::_SchemaNode::_SchemaNode() :
+	types(_SchemaAny),
+	ignore(false),
+	closed(false),
+	skipScalars(false),
+	minimum(-HUGE_VAL),
+	maximum(HUGE_VAL),
+	exclusiveMinimum(NAN),
+	exclusiveMaximum(NAN),
+	minLength(0),
+	maxLength(SIZE_MAX),
+	minItems(0),
+	maxItems(SIZE_MAX),
+	items(nullptr),
+	additional(nullptr),
+	properties(),
+	required()
+{ }
+
+bool CU::_SchemaNode::accepts(const char &first) const noexcept
+{
+	switch (first) {
+		case '{':
+			return ((types & _SchemaObject) != 0);
+		case '[':
+			return ((types & _SchemaArray) != 0);
+		case '\"':
+			return ((types & _SchemaString) != 0);
+		case 't':
+		case 'f':
+			return ((types & _SchemaBoolean) != 0);
+		case 'n':
+			return ((types & _SchemaNull) != 0);
+		default:
+			break;
+	}
+	return ((types & (_SchemaInteger | _SchemaNumber)) != 0);
+}
+
+const CU::_SchemaProperty* CU::_SchemaNode::property(const std::string_view &key) const noexcept
+{
+	const auto iter = _LowerBound(properties, key);
+	if (iter != properties.end() && iter->key == key) {
+		return std::addressof(*iter);
+	}
+	return nullptr;
+}
+
+const char* CU::_SchemaNode::checkNumber(const JSONItem &item) const noexcept
+{
+	const double value = _NumberValue(item);
+	if (item.type() == ItemType::DOUBLE && (types & _SchemaNumber) == 0 && value != std::trunc(value)) {
+		return "Integer expected";
+	}
+	if (value < minimum || value <= exclusiveMinimum) {
+		return "Number below minimum";
+	}
+	if (value > maximum || value >= exclusiveMaximum) {
+		return "Number above maximum";
+	}
+	return nullptr;
+}
+
+// Lengths are counted in code points, as JSON Schema does.
+const char* CU::_SchemaNode::checkString(const std::string_view &str) const noexcept
+{
+	if (minLength == 0 && maxLength == SIZE_MAX) {
+		return nullptr;
+	}
+	size_t length = 0;
+	for (const char ch : str) {
+		if ((static_cast<uint8_t>(ch) & 0xC0) != 0x80) {
+			length++;
+		}
+	}
+	if (length < minLength) {
+		return "String shorter than minLength";
+	} else if (length > maxLength) {
+		return "String longer than maxLength";
+	}
+	return nullptr;
+}
+
+CU::JSONSchema::JSONSchema() : nodes_() { }
+
+CU::JSONSchema::JSONSchema(const JSONObject &schema) : nodes_()
+{
+	_Compile(schema);
+}
+
+CU::JSONSchema::JSONSchema(JSONSchema &&other) noexcept : nodes_(std::move(other.nodes_)) { }
+
+CU::JSONSchema::~JSONSchema() { }
+
+CU::JSONSchema &CU::JSONSchema::operator=(JSONSchema &&other) noexcept
+{
+	if (std::addressof(other) != this) {
+		nodes_ = std::move(other.nodes_);
+	}
+	return *this;
+}
+
+const CU::_SchemaNode* CU::JSONSchema::root() const noexcept
+{
+	if (nodes_.empty()) {
+		return nullptr;
+	}
+	return nodes_.front().get();
+}
+
+const CU::_SchemaNode* CU::JSONSchema::_Compile(const JSONObject &schema)
+{
+	auto &node = *nodes_.emplace_back(std::make_unique<_SchemaNode>());
+	const JSONArray* required = nullptr;
+	for (const auto &[key, value] : schema) {
+		if (key == "type") {
+			if (value.type() == ItemType::ARRAY) {
+				node.types = 0;
+				for (const auto &name : value.asArray()) {
+					node.types |= _TypeBit(name);
+				}
+			} else {
+				node.types = _TypeBit(value);
+			}
+		} else if (key == "ignore") {
+			node.ignore = (value.type() == ItemType::BOOLEAN && value.toBoolean());
+		} else if (key == "minimum") {
+			node.minimum = _Number(value, "minimum");
+		} else if (key == "maximum") {
+			node.maximum = _Number(value, "maximum");
+		} else if (key == "exclusiveMinimum") {
+			node.exclusiveMinimum = _Number(value, "exclusiveMinimum");
+		} else if (key == "exclusiveMaximum") {
+			node.exclusiveMaximum = _Number(value, "exclusiveMaximum");
+		} else if (key == "minLength") {
+			node.minLength = _Count(value, "minLength");
+		} else if (key == "maxLength") {
+			node.maxLength = _Count(value, "maxLength");
+		} else if (key == "minItems") {
+			node.minItems = _Count(value, "minItems");
+		} else if (key == "maxItems") {
+			node.maxItems = _Count(value, "maxItems");
+		} else if (key == "items") {
+			node.items = _Compile(_Object(value, "items"));
+		} else if (key == "properties") {
+			const auto &properties = _Object(value, "properties");
+			for (const auto &[name, property] : properties) {
+				const auto child = _Compile(_Object(property, "property schema"));
+				node.properties.emplace_back(_SchemaProperty{std::string(name), child, _SchemaNoSlot});
+			}
+		} else if (key == "required") {
+			if (value.type() != ItemType::ARRAY) {
+				throw JSONExcept("Invalid schema: required must be an array");
+			}
+			required = std::addressof(value.asArray());
+		} else if (key == "additionalProperties") {
+			if (value.type() == ItemType::BOOLEAN) {
+				node.closed = !value.toBoolean();
+			} else {
+				node.additional = _Compile(_Object(value, "additionalProperties"));
+			}
+		}
+	}
+	std::sort(node.properties.begin(), node.properties.end(),
+		[](const _SchemaProperty &property, const _SchemaProperty &other) { return (property.key < other.key); });
+	if (required != nullptr) {
+		// Required keys without a property schema are still looked up, so they get an entry too.
+		for (const auto &name : *required) {
+			if (name.type() != ItemType::STRING) {
+				throw JSONExcept("Invalid schema: required must hold strings");
+			}
+			const auto iter = _LowerBound(node.properties, name.asString());
+			if (iter == node.properties.end() || iter->key != name.asString()) {
+				node.properties.insert(iter, _SchemaProperty{std::string(name.asString()), node.additional, _SchemaNoSlot});
+			}
+		}
+		for (const auto &name : *required) {
+			auto &property = *_LowerBound(node.properties, name.asString());
+			if (property.required == _SchemaNoSlot) {
+				property.required = node.required.size();
+				node.required.emplace_back(std::addressof(property.key));
+			}
+		}
+	}
+	return std::addressof(node);
+}
+
+CU::JSONProjection::JSONProjection(const std::vector<std::string> &paths) : nodes_()
+{
+	auto &skip = *nodes_.emplace_back(std::make_unique<_SchemaNode>());
+	skip.ignore = true;
+	const auto root = _Level(std::addressof(skip));
+	for (const auto &path : paths) {
+		auto node = root;
+		size_t begin = 0;
+		for (;;) {
+			const auto end = std::min(path.find('.', begin), path.size());
+			const std::string_view key(path.data() + begin, end - begin);
+			if (key.empty()) {
+				throw JSONExcept("Invalid projection path: " + path);
+			}
+			auto iter = _LowerBound(node->properties, key);
+			const bool last = (end == path.size());
+			if (iter == node->properties.end() || iter->key != key) {
+				const auto child = last ? nullptr : _Level(std::addressof(skip));
+				iter = node->properties.insert(iter, _SchemaProperty{std::string(key), child, _SchemaNoSlot});
+			} else if (last) {
+				iter->node = nullptr;
+			}
+			// A null node keeps the whole value, whatever longer paths below it ask for.
+			if (last || iter->node == nullptr) {
+				break;
+			}
+			node = const_cast<_SchemaNode*>(iter->node);
+			begin = end + 1;
+		}
+	}
+}
+
+CU::JSONProjection::JSONProjection(JSONProjection &&other) noexcept : nodes_(std::move(other.nodes_)) { }
+
+CU::JSONProjection::~JSONProjection() { }
+
+CU::JSONProjection &CU::JSONProjection::operator=(JSONProjection &&other) noexcept
+{
+	if (std::addressof(other) != this) {
+		nodes_ = std::move(other.nodes_);
+	}
+	return *this;
+}
+
+const CU::_SchemaNode* CU::JSONProjection::root() const noexcept
+{
+	if (nodes_.size() < 2) {
+		return nullptr;
+	}
+	return nodes_[1].get();
+}
+
+// One object level of the projection: unlisted keys go to the skip node, arrays apply
+// the same level to their elements and scalars in its place are skipped.
+CU::_SchemaNode* CU::JSONProjection::_Level(const _SchemaNode* skip)
+{
+	auto &node = *nodes_.emplace_back(std::make_unique<_SchemaNode>());
+	node.additional = skip;
+	node.items = std::addressof(node);
+	node.skipScalars = true;
+	return std::addressof(node);
+}
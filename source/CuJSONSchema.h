@@ -0,0 +1,115 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONSCHEMA_
+#define _CU_JSONSCHEMA_
+
+#include "CuJSONObject.h"
+#include <memory>
+
+namespace CU
+{
+	constexpr uint8_t _SchemaNull = 0x01;
+	constexpr uint8_t _SchemaBoolean = 0x02;
+	constexpr uint8_t _SchemaInteger = 0x04;
+	constexpr uint8_t _SchemaNumber = 0x08;
+	constexpr uint8_t _SchemaString = 0x10;
+	constexpr uint8_t _SchemaArray = 0x20;
+	constexpr uint8_t _SchemaObject = 0x40;
+	constexpr uint8_t _SchemaAny = 0x7F;
+	constexpr size_t _SchemaNoSlot = static_cast<size_t>(-1);
+
+	struct _SchemaNode;
+
+	// A null node places no constraint on the value. required is the slot of the key
+	// in its object's required list, or _SchemaNoSlot.
+	struct _SchemaProperty
+	{
+		std::string key;
+		const _SchemaNode* node;
+		size_t required;
+	};
+
+	struct _SchemaNode
+	{
+		uint8_t types;
+		bool ignore;
+		bool closed;
+		// Set on projection levels: a member or element that is a scalar has none of the
+		// selected members, so it is skipped like an ignored value.
+		bool skipScalars;
+		// Inclusive bounds, and exclusive ones that are NaN when absent so they never reject.
+		double minimum;
+		double maximum;
+		double exclusiveMinimum;
+		double exclusiveMaximum;
+		size_t minLength;
+		size_t maxLength;
+		size_t minItems;
+		size_t maxItems;
+		const _SchemaNode* items;
+		const _SchemaNode* additional;
+		std::vector<_SchemaProperty> properties;
+		std::vector<const std::string*> required;
+
+		_SchemaNode();
+
+		// Type check on the first character of a value, before anything is built.
+		bool accepts(const char &first) const noexcept;
+		const _SchemaProperty* property(const std::string_view &key) const noexcept;
+		// Return the reason of the violation, or nullptr.
+		const char* checkNumber(const JSONItem &item) const noexcept;
+		const char* checkString(const std::string_view &str) const noexcept;
+	};
+
+	// Subset of JSON Schema compiled for JSONParser::parse(), which checks it while the
+	// text is parsed and throws at the first violation. Supported keywords: type, properties,
+	// required, additionalProperties, items, minimum, maximum, exclusiveMinimum,
+	// exclusiveMaximum, minLength, maxLength, minItems and maxItems; others are ignored.
+	// "ignore": true marks a member or item that is skipped without building it.
+	class JSONSchema
+	{
+		public:
+			JSONSchema();
+			JSONSchema(const JSONObject &schema);
+			JSONSchema(JSONSchema &&other) noexcept;
+			~JSONSchema();
+
+			JSONSchema(const JSONSchema &) = delete;
+			JSONSchema &operator=(const JSONSchema &) = delete;
+			JSONSchema &operator=(JSONSchema &&other) noexcept;
+
+			const _SchemaNode* root() const noexcept;
+
+		private:
+			std::vector<std::unique_ptr<_SchemaNode>> nodes_;
+
+			const _SchemaNode* _Compile(const JSONObject &schema);
+	};
+
+	// Dotted key paths ("user.name") kept by JSONParser::parse(), which skips every other
+	// member without unescaping, converting or allocating anything for it. Paths continue
+	// through arrays, so "items.id" keeps the id of each element of items; a path that ends
+	// at a container keeps all of it. A scalar where a path continues is skipped, so are
+	// the scalar elements of arrays the path goes through.
+	class JSONProjection
+	{
+		public:
+			JSONProjection(const std::vector<std::string> &paths);
+			JSONProjection(JSONProjection &&other) noexcept;
+			~JSONProjection();
+
+			JSONProjection(const JSONProjection &) = delete;
+			JSONProjection &operator=(const JSONProjection &) = delete;
+			JSONProjection &operator=(JSONProjection &&other) noexcept;
+
+			const _SchemaNode* root() const noexcept;
+
+		private:
+			std::vector<std::unique_ptr<_SchemaNode>> nodes_;
+
+			_SchemaNode* _Level(const _SchemaNode* skip);
+	};
+}
+
+#endif // _CU_JSONSCHEMA_
@@ -0,0 +1,557 @@
+#include "CuJSONSnapshot.h"
+#include "CuJSONParser.h"
+#include "CuJSONStats.h"
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CU
+{
+	namespace
+	{
+		constexpr char _SnapshotMagic[8] = {'C', 'U', 'J', 'S', 'N', 'A', 'P', '1'};
+		constexpr uint32_t _SnapshotByteOrder = 0x01020304;
+		constexpr uint32_t _SnapshotVersion = 1;
+
+		struct _SnapshotHeader
+		{
+			char magic[8];
+			uint32_t byteOrder;
+			uint32_t version;
+			uint64_t size;
+			_SnapshotValue root;
+		};
+
+		static_assert(sizeof(_SnapshotValue) == 16, "snapshot records are 16 bytes");
+		static_assert(sizeof(_SnapshotHeader) == 40, "snapshot header is 40 bytes");
+
+		_SnapshotValue _MakeValue(const ItemType &type, const size_t &count, const uint64_t &payload)
+		{
+			if (count > UINT32_MAX) {
+				throw JSONExcept("Snapshot container or string too large");
+			}
+			_SnapshotValue value{};
+			value.type = static_cast<uint8_t>(type);
+			value.count = static_cast<uint32_t>(count);
+			value.payload = payload;
+			return value;
+		}
+
+		class _SnapshotWriter
+		{
+			public:
+				_SnapshotWriter(std::string &buffer) : buffer_(buffer), base_(buffer.size()) { }
+
+				template <typename _Value>
+				void write(const _Value &root)
+				{
+					const auto header = _Reserve(sizeof(_SnapshotHeader));
+					const auto value = _Write(root);
+					_SnapshotHeader snapshotHeader{};
+					std::memcpy(snapshotHeader.magic, _SnapshotMagic, sizeof(_SnapshotMagic));
+					snapshotHeader.byteOrder = _SnapshotByteOrder;
+					snapshotHeader.version = _SnapshotVersion;
+					snapshotHeader.size = buffer_.size() - base_;
+					snapshotHeader.root = value;
+					std::memcpy(buffer_.data() + base_ + header, &snapshotHeader, sizeof(snapshotHeader));
+				}
+
+			private:
+				std::string &buffer_;
+				size_t base_;
+
+				// Returns the offset of a zeroed, 8-byte aligned block relative to the snapshot start.
+				uint64_t _Reserve(const size_t &length)
+				{
+					const auto offset = (buffer_.size() - base_ + 7) & ~static_cast<size_t>(7);
+					buffer_.resize(base_ + offset + length);
+					return offset;
+				}
+
+				void _Store(const uint64_t &offset, const _SnapshotValue &value)
+				{
+					std::memcpy(buffer_.data() + base_ + offset, &value, sizeof(value));
+				}
+
+				_SnapshotValue _Write(const JSONItem &item)
+				{
+					uint64_t payload = 0;
+					switch (item.type()) {
+						case ItemType::BOOLEAN:
+							payload = item.toBoolean() ? 1 : 0;
+							break;
+						case ItemType::INTEGER:
+							payload = static_cast<uint64_t>(static_cast<int64_t>(item.toInt()));
+							break;
+						case ItemType::LONG:
+							payload = static_cast<uint64_t>(item.toLong());
+							break;
+						case ItemType::DOUBLE:
+							{
+								const double number = item.toDouble();
+								std::memcpy(&payload, &number, sizeof(payload));
+							}
+							break;
+						case ItemType::STRING:
+							return _Write(item.asString());
+						case ItemType::ARRAY:
+							return _Write(item.asArray());
+						case ItemType::OBJECT:
+							return _Write(item.asObject());
+						default:
+							break;
+					}
+					return _MakeValue(item.type(), 0, payload);
+				}
+
+				// Strings are NUL terminated so the bytes can be handed to C APIs as well.
+				_SnapshotValue _Write(const std::string_view &str)
+				{
+					const auto offset = _Reserve(str.size() + 1);
+					std::memcpy(buffer_.data() + base_ + offset, str.data(), str.size());
+					return _MakeValue(ItemType::STRING, str.size(), offset);
+				}
+
+				_SnapshotValue _Write(const JSONArray &array)
+				{
+					const auto offset = _Reserve(array.size() * sizeof(_SnapshotValue));
+					uint64_t slot = offset;
+					for (const auto &item : array) {
+						const auto value = _Write(item);
+						_Store(slot, value);
+						slot += sizeof(_SnapshotValue);
+					}
+					return _MakeValue(ItemType::ARRAY, array.size(), offset);
+				}
+
+				// Keys, then values, both in member order, then the member indexes sorted by key.
+				_SnapshotValue _Write(const JSONObject &object)
+				{
+					const auto members = object.begin();
+					const auto count = object.size();
+					const auto offset = _Reserve(count * (2 * sizeof(_SnapshotValue) + sizeof(uint32_t)));
+					std::vector<uint32_t> sorted(count);
+					for (size_t pos = 0; pos < count; pos++) {
+						sorted[pos] = static_cast<uint32_t>(pos);
+						const auto key = _Write(std::string_view(members[pos].first));
+						_Store(offset + pos * sizeof(_SnapshotValue), key);
+						const auto value = _Write(members[pos].second);
+						_Store(offset + (count + pos) * sizeof(_SnapshotValue), value);
+					}
+					std::sort(sorted.begin(), sorted.end(), [&members](const uint32_t &pos, const uint32_t &other) {
+						return (std::string_view(members[pos].first) < std::string_view(members[other].first));
+					});
+					if (count != 0) {
+						std::memcpy(buffer_.data() + base_ + offset + 2 * count * sizeof(_SnapshotValue), sorted.data(), count * sizeof(uint32_t));
+					}
+					return _MakeValue(ItemType::OBJECT, count, offset);
+				}
+		};
+
+		template <typename _Value>
+		void _WriteSnapshot(const _Value &value, std::string &buffer)
+		{
+			_CU_STATS_PHASE(SERIALIZE, 0);
+			const auto begin = buffer.size();
+			_SnapshotWriter(buffer).write(value);
+			_CU_STATS_OUTPUT(buffer.size() - begin);
+			(void)begin;
+		}
+	}
+}
+
+void CU::WriteSnapshot(const JSONItem &item, std::string &buffer)
+{
+	_WriteSnapshot(item, buffer);
+}
+
+void CU::WriteSnapshot(const JSONArray &array, std::string &buffer)
+{
+	_WriteSnapshot(array, buffer);
+}
+
+void CU::WriteSnapshot(const JSONObject &object, std::string &buffer)
+{
+	_WriteSnapshot(object, buffer);
+}
+
+std::string CU::ToSnapshot(const JSONItem &item)
+{
+	std::string buffer{};
+	_WriteSnapshot(item, buffer);
+	return buffer;
+}
+
+std::string CU::ToSnapshot(const JSONArray &array)
+{
+	std::string buffer{};
+	_WriteSnapshot(array, buffer);
+	return buffer;
+}
+
+std::string CU::ToSnapshot(const JSONObject &object)
+{
+	std::string buffer{};
+	_WriteSnapshot(object, buffer);
+	return buffer;
+}
+
+CU::JSONView::JSONView() : base_(nullptr), size_(0), value_() { }
+
+CU::JSONView::JSONView(const char* base, const size_t &size, const _SnapshotValue &value) :
+	base_(base),
+	size_(size),
+	value_(value)
+{ }
+
+CU::ItemType CU::JSONView::type() const
+{
+	return static_cast<ItemType>(value_.type);
+}
+
+size_t CU::JSONView::size() const
+{
+	switch (type()) {
+		case ItemType::STRING:
+		case ItemType::ARRAY:
+		case ItemType::OBJECT:
+			return value_.count;
+		default:
+			break;
+	}
+	return 0;
+}
+
+bool CU::JSONView::toBoolean() const
+{
+	if (type() == ItemType::BOOLEAN) {
+		return (value_.payload != 0);
+	}
+	return {};
+}
+
+int CU::JSONView::toInt() const
+{
+	if (type() == ItemType::INTEGER) {
+		return static_cast<int>(static_cast<int64_t>(value_.payload));
+	}
+	return {};
+}
+
+int64_t CU::JSONView::toLong() const
+{
+	if (type() == ItemType::LONG) {
+		return static_cast<int64_t>(value_.payload);
+	}
+	return {};
+}
+
+double CU::JSONView::toDouble() const
+{
+	if (type() == ItemType::DOUBLE) {
+		double number = 0.0;
+		std::memcpy(&number, &value_.payload, sizeof(number));
+		return number;
+	}
+	return {};
+}
+
+std::string_view CU::JSONView::toString() const
+{
+	if (type() == ItemType::STRING) {
+		return std::string_view(_Range(value_.payload, value_.count), value_.count);
+	}
+	return {};
+}
+
+CU::JSONView CU::JSONView::at(const size_t &pos) const
+{
+	if (type() != ItemType::ARRAY) {
+		throw JSONExcept("View is not a JSONArray");
+	}
+	if (pos >= value_.count) {
+		throw JSONExcept("Position out of bound");
+	}
+	return JSONView(base_, size_, _Record(value_.payload + pos * sizeof(_SnapshotValue)));
+}
+
+CU::JSONView CU::JSONView::at(const std::string_view &key) const
+{
+	_SnapshotValue value{};
+	if (!_Find(key, value)) {
+		throw JSONExcept("Key not found");
+	}
+	return JSONView(base_, size_, value);
+}
+
+bool CU::JSONView::contains(const std::string_view &key) const
+{
+	_SnapshotValue value{};
+	return _Find(key, value);
+}
+
+std::string_view CU::JSONView::key(const size_t &pos) const
+{
+	if (type() != ItemType::OBJECT) {
+		throw JSONExcept("View is not a JSONObject");
+	}
+	if (pos >= value_.count) {
+		throw JSONExcept("Position out of bound");
+	}
+	return JSONView(base_, size_, _Record(value_.payload + pos * sizeof(_SnapshotValue))).toString();
+}
+
+CU::JSONItem CU::JSONView::toItem() const
+{
+	uint64_t next = 0;
+	return _ToItem(JSONParser::Options().maxDepth, next);
+}
+
+const char* CU::JSONView::_Range(const uint64_t &offset, const uint64_t &length) const
+{
+	if (offset > size_ || length > size_ - offset) {
+		throw JSONExcept("Snapshot offset out of range");
+	}
+	return base_ + offset;
+}
+
+// Converts in the order the writer lays the records out, so the records of each container
+// have to start past those of the containers converted before it. Damaged or crafted
+// offsets can then neither loop back into an ancestor nor share a subtree, and nesting
+// is limited like JSONParser's.
+CU::JSONItem CU::JSONView::_ToItem(const size_t &depth, uint64_t &next) const
+{
+	switch (type()) {
+		case ItemType::ARRAY:
+			{
+				const uint64_t count = value_.count;
+				_Claim(count * sizeof(_SnapshotValue), depth, next);
+				JSONItem item(JSONArray(static_cast<size_t>(count)));
+				auto &array = item.asArray();
+				for (size_t pos = 0; pos < count; pos++) {
+					array[pos] = JSONView(base_, size_, _Record(value_.payload + pos * sizeof(_SnapshotValue)))._ToItem(depth - 1, next);
+				}
+				return item;
+			}
+		case ItemType::OBJECT:
+			{
+				const uint64_t count = value_.count;
+				_Claim(count * (2 * sizeof(_SnapshotValue) + sizeof(uint32_t)), depth, next);
+				JSONItem item(JSONObject{});
+				auto &object = item.asObject();
+				for (size_t pos = 0; pos < count; pos++) {
+					const auto member = JSONView(base_, size_, _Record(value_.payload + (count + pos) * sizeof(_SnapshotValue)));
+					object[std::string(key(pos))] = member._ToItem(depth - 1, next);
+				}
+				return item;
+			}
+		case ItemType::BOOLEAN:
+			return JSONItem(toBoolean());
+		case ItemType::INTEGER:
+			return JSONItem(toInt());
+		case ItemType::LONG:
+			return JSONItem(toLong());
+		case ItemType::DOUBLE:
+			return JSONItem(toDouble());
+		case ItemType::STRING:
+			return JSONItem(std::string(toString()));
+		default:
+			break;
+	}
+	return JSONItem();
+}
+
+// Checks the records of a container before anything is allocated for them.
+void CU::JSONView::_Claim(const uint64_t &length, const size_t &depth, uint64_t &next) const
+{
+	if (depth == 0) {
+		throw JSONExcept("Snapshot nesting too deep");
+	}
+	if (value_.payload < next) {
+		throw JSONExcept("Snapshot records out of order");
+	}
+	_Range(value_.payload, length);
+	next = value_.payload + length;
+}
+
+CU::_SnapshotValue CU::JSONView::_Record(const uint64_t &offset) const
+{
+	_SnapshotValue value{};
+	std::memcpy(&value, _Range(offset, sizeof(value)), sizeof(value));
+	return value;
+}
+
+// Binary search over the sorted member index.
+bool CU::JSONView::_Find(const std::string_view &key, _SnapshotValue &value) const
+{
+	if (type() != ItemType::OBJECT) {
+		throw JSONExcept("View is not a JSONObject");
+	}
+	const uint64_t count = value_.count;
+	const auto index = _Range(value_.payload + 2 * count * sizeof(_SnapshotValue), count * sizeof(uint32_t));
+	size_t low = 0;
+	size_t high = count;
+	while (low < high) {
+		const auto mid = low + (high - low) / 2;
+		uint32_t pos = 0;
+		std::memcpy(&pos, index + mid * sizeof(uint32_t), sizeof(pos));
+		if (pos >= count) {
+			throw JSONExcept("Snapshot offset out of range");
+		}
+		const auto candidate = JSONView(base_, size_, _Record(value_.payload + pos * sizeof(_SnapshotValue))).toString();
+		if (candidate < key) {
+			low = mid + 1;
+		} else if (key < candidate) {
+			high = mid;
+		} else {
+			value = _Record(value_.payload + (count + pos) * sizeof(_SnapshotValue));
+			return true;
+		}
+	}
+	return false;
+}
+
+CU::JSONSnapshot::JSONSnapshot() : data_(nullptr), size_(0), mapped_(false) { }
+
+CU::JSONSnapshot::JSONSnapshot(const std::string_view &bytes) : data_(nullptr), size_(0), mapped_(false)
+{
+	_Attach(bytes.data(), bytes.size());
+}
+
+CU::JSONSnapshot::JSONSnapshot(JSONSnapshot &&other) noexcept :
+	data_(other.data_),
+	size_(other.size_),
+	mapped_(other.mapped_)
+{
+	other.data_ = nullptr;
+	other.size_ = 0;
+	other.mapped_ = false;
+}
+
+CU::JSONSnapshot::~JSONSnapshot()
+{
+	close();
+}
+
+CU::JSONSnapshot &CU::JSONSnapshot::operator=(JSONSnapshot &&other) noexcept
+{
+	if (std::addressof(other) != this) {
+		close();
+		data_ = other.data_;
+		size_ = other.size_;
+		mapped_ = other.mapped_;
+		other.data_ = nullptr;
+		other.size_ = 0;
+		other.mapped_ = false;
+	}
+	return *this;
+}
+
+// Maps the file read-only; pages are faulted in as the views touch them.
+void CU::JSONSnapshot::open(const std::string &path)
+{
+	close();
+#if defined(_WIN32)
+	auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw JSONExcept("Failed to open snapshot: " + path);
+	}
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(file, &fileSize);
+	auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		throw JSONExcept("Failed to map snapshot: " + path);
+	}
+	auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == nullptr) {
+		throw JSONExcept("Failed to map snapshot: " + path);
+	}
+	const auto size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw JSONExcept("Failed to open snapshot: " + path);
+	}
+	struct stat fileStat{};
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		::close(fd);
+		throw JSONExcept("Failed to open snapshot: " + path);
+	}
+	const auto size = static_cast<size_t>(fileStat.st_size);
+	auto data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		throw JSONExcept("Failed to map snapshot: " + path);
+	}
+#endif
+	data_ = static_cast<const char*>(data);
+	size_ = size;
+	mapped_ = true;
+	try {
+		_Attach(data_, size_);
+	} catch (...) {
+		close();
+		throw;
+	}
+}
+
+void CU::JSONSnapshot::close() noexcept
+{
+	if (mapped_) {
+#if defined(_WIN32)
+		UnmapViewOfFile(data_);
+#else
+		munmap(const_cast<char*>(data_), size_);
+#endif
+	}
+	data_ = nullptr;
+	size_ = 0;
+	mapped_ = false;
+}
+
+CU::JSONView CU::JSONSnapshot::root() const
+{
+	if (data_ == nullptr) {
+		throw JSONExcept("Snapshot not loaded");
+	}
+	_SnapshotHeader header{};
+	std::memcpy(&header, data_, sizeof(header));
+	return JSONView(data_, size_, header.root);
+}
+
+size_t CU::JSONSnapshot::size() const
+{
+	return size_;
+}
+
+void CU::JSONSnapshot::_Attach(const char* data, const size_t &size)
+{
+	_SnapshotHeader header{};
+	if (size < sizeof(header)) {
+		throw JSONExcept("Invalid snapshot: too small");
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, _SnapshotMagic, sizeof(_SnapshotMagic)) != 0) {
+		throw JSONExcept("Invalid snapshot: bad magic");
+	}
+	if (header.byteOrder != _SnapshotByteOrder) {
+		throw JSONExcept("Invalid snapshot: written with another byte order");
+	}
+	if (header.version != _SnapshotVersion) {
+		throw JSONExcept("Invalid snapshot: unsupported version");
+	}
+	if (header.size != size) {
+		throw JSONExcept("Invalid snapshot: size mismatch");
+	}
+	data_ = data;
+	size_ = size;
+}
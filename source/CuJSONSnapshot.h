@@ -0,0 +1,100 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONSNAPSHOT_
+#define _CU_JSONSNAPSHOT_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	// Fixed 16-byte value record of the snapshot format. Strings, arrays and objects
+	// keep their length in count and the offset (from the start of the snapshot) of
+	// their bytes, elements or members in payload; scalars are stored in payload.
+	struct _SnapshotValue
+	{
+		uint8_t type;
+		uint8_t reserved[3];
+		uint32_t count;
+		uint64_t payload;
+	};
+
+	// Serializes a tree into the snapshot format: a header followed by 8-byte aligned,
+	// offset addressed records, so the bytes can be saved once and used in place
+	// from any address. Objects keep their member order plus a sorted key index.
+	void WriteSnapshot(const JSONItem &item, std::string &buffer);
+	void WriteSnapshot(const JSONArray &array, std::string &buffer);
+	void WriteSnapshot(const JSONObject &object, std::string &buffer);
+
+	std::string ToSnapshot(const JSONItem &item);
+	std::string ToSnapshot(const JSONArray &array);
+	std::string ToSnapshot(const JSONObject &object);
+
+	// Read-only handle to one value of a snapshot, 32 bytes, cheap to copy. Accessors
+	// read the records in place; offsets are bounds checked on access, so a damaged
+	// file throws JSONExcept instead of reading outside the mapping; toItem() also rejects
+	// containers nested too deep or pointing back into the tree. The conversions behave
+	// like JSONItem's and return a default value for another type.
+	class JSONView
+	{
+		public:
+			JSONView();
+
+			ItemType type() const;
+			size_t size() const;
+			bool toBoolean() const;
+			int toInt() const;
+			int64_t toLong() const;
+			double toDouble() const;
+			std::string_view toString() const;
+
+			JSONView at(const size_t &pos) const;
+			JSONView at(const std::string_view &key) const;
+			bool contains(const std::string_view &key) const;
+			std::string_view key(const size_t &pos) const;
+			JSONItem toItem() const;
+
+		private:
+			friend class JSONSnapshot;
+
+			const char* base_;
+			size_t size_;
+			_SnapshotValue value_;
+
+			JSONView(const char* base, const size_t &size, const _SnapshotValue &value);
+			const char* _Range(const uint64_t &offset, const uint64_t &length) const;
+			_SnapshotValue _Record(const uint64_t &offset) const;
+			JSONItem _ToItem(const size_t &depth, uint64_t &next) const;
+			void _Claim(const uint64_t &length, const size_t &depth, uint64_t &next) const;
+			bool _Find(const std::string_view &key, _SnapshotValue &value) const;
+	};
+
+	// A loaded snapshot, either memory mapped from a file by open() or borrowed from
+	// caller owned bytes that must outlive it. Loading only checks the header.
+	class JSONSnapshot
+	{
+		public:
+			JSONSnapshot();
+			JSONSnapshot(const std::string_view &bytes);
+			JSONSnapshot(JSONSnapshot &&other) noexcept;
+			~JSONSnapshot();
+
+			JSONSnapshot(const JSONSnapshot &) = delete;
+			JSONSnapshot &operator=(const JSONSnapshot &) = delete;
+			JSONSnapshot &operator=(JSONSnapshot &&other) noexcept;
+
+			void open(const std::string &path);
+			void close() noexcept;
+			JSONView root() const;
+			size_t size() const;
+
+		private:
+			const char* data_;
+			size_t size_;
+			bool mapped_;
+
+			void _Attach(const char* data, const size_t &size);
+	};
+}
+
+#endif // _CU_JSONSNAPSHOT_
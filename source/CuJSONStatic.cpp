@@ -0,0 +1,58 @@
+#include "CuJSONStatic.h"
+#include <charconv>
+
+void CU::_StaticThrow(const char* reason, const size_t &offset)
+{
+	throw JSONExcept("Invalid JSON at offset " + std::to_string(offset) + ": " + reason);
+}
+
+// Out of range values convert like JSONParser does.
+double CU::_StaticDouble(const std::string_view &text)
+{
+	double value = 0.0;
+	const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (result.ec == std::errc::result_out_of_range) {
+		value = strtod(std::string(text).c_str(), nullptr);
+	}
+	return value;
+}
+
+// Children are visited by following end from one sibling to the next.
+CU::JSONItem CU::JSONStaticView::toItem() const
+{
+	switch (type()) {
+		case ItemType::BOOLEAN:
+			return JSONItem(toBoolean());
+		case ItemType::INTEGER:
+			return JSONItem(toInt());
+		case ItemType::LONG:
+			return JSONItem(toLong());
+		case ItemType::DOUBLE:
+			return JSONItem(toDouble());
+		case ItemType::STRING:
+			return JSONItem(std::string(toString()));
+		case ItemType::ARRAY:
+			{
+				JSONItem item(JSONArray(static_cast<size_t>(size())));
+				auto &array = item.asArray();
+				size_t pos = 0;
+				for (auto index = index_ + 1; index < _Node().end; index = nodes_[index].end) {
+					array[pos++] = JSONStaticView(nodes_, chars_, index).toItem();
+				}
+				return item;
+			}
+		case ItemType::OBJECT:
+			{
+				JSONItem item(JSONObject{});
+				auto &object = item.asObject();
+				for (auto index = index_ + 1; index < _Node().end; index = nodes_[index].end) {
+					const auto &node = nodes_[index];
+					object[std::string(chars_ + node.key, node.keySize)] = JSONStaticView(nodes_, chars_, index).toItem();
+				}
+				return item;
+			}
+		default:
+			break;
+	}
+	return JSONItem();
+}
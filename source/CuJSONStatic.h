@@ -0,0 +1,648 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONSTATIC_
+#define _CU_JSONSTATIC_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	// Value record of a static document, in document order. end is the index after the
+	// value's subtree, so the next sibling is nodes[end]. count is the size of a container
+	// or of the text, and 1 for true. Strings, numbers and member keys keep their text in
+	// the document's character array, a value's right after its key at key + keySize.
+	struct _StaticNode
+	{
+		ItemType type = ItemType::ITEM_NULL;
+		uint32_t count = 0;
+		uint32_t end = 0;
+		uint32_t key = 0;
+		uint32_t keySize = 0;
+	};
+
+	// Digits of a number's text, the first 19 significant ones in mantissa and the rest
+	// counted in exponent.
+	struct _StaticDigits
+	{
+		uint64_t mantissa = 0;
+		size_t significant = 0;
+		int exponent = 0;
+		bool negative = false;
+		bool integral = true;
+	};
+
+	// Numbers are kept as text and scanned again when read; the text is already valid.
+	constexpr _StaticDigits _StaticScan(const std::string_view &text) noexcept;
+
+	// Not constexpr: reached at compile time, they turn a syntax error into a compile error.
+	[[noreturn]] void _StaticThrow(const char* reason, const size_t &offset);
+	double _StaticDouble(const std::string_view &text);
+
+	// Read-only handle to one value of a JSONStatic, cheap to copy. The conversions behave
+	// like JSONItem's and return a default value for another type; numbers are read from
+	// their text on each call. Everything but toItem() can run at compile time; toDouble()
+	// too unless the number is not exactly representable from its digits (more than 2^53 or
+	// an exponent beyond 22), which is converted at run time.
+	class JSONStaticView
+	{
+		public:
+			constexpr JSONStaticView() noexcept;
+			constexpr JSONStaticView(const _StaticNode* nodes, const char* chars, const size_t &index) noexcept;
+
+			constexpr ItemType type() const noexcept;
+			constexpr size_t size() const noexcept;
+			constexpr bool toBoolean() const noexcept;
+			constexpr int toInt() const noexcept;
+			constexpr int64_t toLong() const noexcept;
+			constexpr double toDouble() const;
+			constexpr std::string_view toString() const noexcept;
+
+			// Containers are walked from their first child, lookups cost one step per
+			// preceding element or member.
+			constexpr JSONStaticView at(const size_t &pos) const;
+			constexpr JSONStaticView at(const std::string_view &key) const;
+			constexpr bool contains(const std::string_view &key) const noexcept;
+			constexpr std::string_view key(const size_t &pos) const;
+			JSONItem toItem() const;
+
+		private:
+			const _StaticNode* nodes_;
+			const char* chars_;
+			size_t index_;
+
+			constexpr const _StaticNode &_Node() const noexcept;
+			constexpr std::string_view _Text() const noexcept;
+			constexpr size_t _Find(const std::string_view &key) const noexcept;
+	};
+
+	template <size_t _Nodes, size_t _Chars>
+	class JSONStatic;
+
+	constexpr size_t _StaticNodes(const size_t &nodes, const size_t &size) noexcept
+	{
+		return (nodes != 0) ? nodes : size / 2 + 1;
+	}
+
+	// Parses a JSON literal in a constant expression: invalid text fails to compile, at
+	// the call of _StaticThrow() with the reason and offset. At run time it throws
+	// JSONExcept like JSONParser. The document holds _Nodes values, the worst case of the
+	// literal when 0; a smaller count given as ParseStatic<Nodes>() saves a node of 20
+	// bytes per two characters, and fails to compile if the literal needs more.
+	template <size_t _Nodes = 0, size_t _Size>
+	constexpr JSONStatic<_StaticNodes(_Nodes, _Size), _Size> ParseStatic(const char (&text)[_Size]);
+
+	// A document laid out in fixed arrays, built by ParseStatic().
+	template <size_t _Nodes, size_t _Chars>
+	class JSONStatic
+	{
+		public:
+			constexpr JSONStatic() noexcept : nodes_(), chars_(), nodeCount_(0), charCount_(0) { }
+
+			constexpr JSONStaticView root() const noexcept
+			{
+				return JSONStaticView(nodes_, chars_, 0);
+			}
+
+			constexpr size_t nodeCount() const noexcept
+			{
+				return nodeCount_;
+			}
+
+			constexpr size_t charCount() const noexcept
+			{
+				return charCount_;
+			}
+
+		private:
+			template <size_t _Count, size_t _Size>
+			friend constexpr JSONStatic<_StaticNodes(_Count, _Size), _Size> ParseStatic(const char (&text)[_Size]);
+
+			_StaticNode nodes_[_Nodes];
+			char chars_[_Chars];
+			size_t nodeCount_;
+			size_t charCount_;
+	};
+
+	// Single pass parser over a string literal, usable in constant expressions. Accepts
+	// the syntax of JSONParser except for numbers, which must be strict JSON, and types
+	// numbers like it does. Nesting is kept in an explicit stack.
+	template <size_t _Nodes, size_t _Chars>
+	class _StaticParser
+	{
+		public:
+			constexpr _StaticParser(const char* text, const size_t &size, _StaticNode* nodes, char* chars) noexcept :
+				text_(text),
+				size_(size),
+				pos_(0),
+				nodes_(nodes),
+				chars_(chars),
+				nodeCount_(0),
+				charCount_(0),
+				stack_(),
+				depth_(0)
+			{ }
+
+			constexpr void parse()
+			{
+				_ParseValue(0, 0);
+				while (depth_ != 0) {
+					auto &parent = nodes_[stack_[depth_ - 1]];
+					_SkipSpace();
+					if (pos_ == size_) {
+						_StaticThrow("Unterminated container", pos_);
+					}
+					const char close = (parent.type == ItemType::ARRAY) ? ']' : '}';
+					if (text_[pos_] == close) {
+						pos_++;
+						parent.end = static_cast<uint32_t>(nodeCount_);
+						depth_--;
+						continue;
+					}
+					if (parent.count != 0) {
+						if (text_[pos_] != ',') {
+							_StaticThrow((close == ']') ? "',' or ']' expected" : "',' or '}' expected", pos_);
+						}
+						pos_++;
+						_SkipSpace();
+					}
+					uint32_t key = static_cast<uint32_t>(charCount_);
+					uint32_t keySize = 0;
+					if (close == '}') {
+						if (pos_ == size_ || text_[pos_] != '\"') {
+							_StaticThrow("Key expected", pos_);
+						}
+						key = static_cast<uint32_t>(charCount_);
+						_ParseString();
+						keySize = static_cast<uint32_t>(charCount_) - key;
+						_SkipSpace();
+						if (pos_ == size_ || text_[pos_] != ':') {
+							_StaticThrow("':' expected", pos_);
+						}
+						pos_++;
+					}
+					parent.count++;
+					_ParseValue(key, keySize);
+				}
+				_SkipSpace();
+				if (pos_ != size_) {
+					_StaticThrow("Unexpected trailing characters", pos_);
+				}
+			}
+
+			constexpr size_t nodeCount() const noexcept
+			{
+				return nodeCount_;
+			}
+
+			constexpr size_t charCount() const noexcept
+			{
+				return charCount_;
+			}
+
+		private:
+			const char* text_;
+			size_t size_;
+			size_t pos_;
+			_StaticNode* nodes_;
+			char* chars_;
+			size_t nodeCount_;
+			size_t charCount_;
+			size_t stack_[_Nodes];
+			size_t depth_;
+
+			static constexpr bool _IsDigit(const char &ch) noexcept
+			{
+				return (ch >= '0' && ch <= '9');
+			}
+
+			static constexpr int _HexValue(const char &ch) noexcept
+			{
+				if (ch >= '0' && ch <= '9') {
+					return ch - '0';
+				} else if (ch >= 'a' && ch <= 'f') {
+					return ch - 'a' + 10;
+				} else if (ch >= 'A' && ch <= 'F') {
+					return ch - 'A' + 10;
+				}
+				return -1;
+			}
+
+			constexpr void _SkipSpace() noexcept
+			{
+				while (pos_ != size_) {
+					switch (text_[pos_]) {
+						case ' ':
+						case '\n':
+						case '\t':
+						case '\r':
+						case '\f':
+						case '\a':
+						case '\b':
+						case '\v':
+							pos_++;
+							break;
+						default:
+							return;
+					}
+				}
+			}
+
+			// Containers stay open on the stack, every other value is complete on return.
+			constexpr void _ParseValue(const uint32_t &key, const uint32_t &keySize)
+			{
+				_SkipSpace();
+				if (pos_ == size_) {
+					_StaticThrow("Value expected", pos_);
+				} else if (nodeCount_ == _Nodes) {
+					_StaticThrow("Maximum element count exceeded", pos_);
+				}
+				auto &node = nodes_[nodeCount_];
+				const auto index = nodeCount_;
+				nodeCount_++;
+				node.key = key;
+				node.keySize = keySize;
+				switch (text_[pos_]) {
+					case '{':
+					case '[':
+						node.type = (text_[pos_] == '{') ? ItemType::OBJECT : ItemType::ARRAY;
+						pos_++;
+						stack_[depth_] = index;
+						depth_++;
+						return;
+					case '\"':
+						node.type = ItemType::STRING;
+						_ParseString();
+						node.count = static_cast<uint32_t>(charCount_) - key - keySize;
+						break;
+					case 't':
+						_ParseLiteral("true", 4);
+						node.type = ItemType::BOOLEAN;
+						node.count = 1;
+						break;
+					case 'f':
+						_ParseLiteral("false", 5);
+						node.type = ItemType::BOOLEAN;
+						break;
+					case 'n':
+						_ParseLiteral("null", 4);
+						node.type = ItemType::ITEM_NULL;
+						break;
+					default:
+						_ParseNumber(node);
+						break;
+				}
+				node.end = static_cast<uint32_t>(nodeCount_);
+			}
+
+			constexpr void _ParseLiteral(const char* literal, const size_t &length)
+			{
+				for (size_t i = 0; i < length; i++) {
+					if (pos_ + i == size_ || text_[pos_ + i] != literal[i]) {
+						_StaticThrow("Invalid value", pos_);
+					}
+				}
+				pos_ += length;
+			}
+
+			constexpr void _Append(const uint32_t &codePoint) noexcept
+			{
+				if (codePoint < 0x80) {
+					chars_[charCount_++] = static_cast<char>(codePoint);
+				} else if (codePoint < 0x800) {
+					chars_[charCount_++] = static_cast<char>(0xC0 | (codePoint >> 6));
+					chars_[charCount_++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+				} else if (codePoint < 0x10000) {
+					chars_[charCount_++] = static_cast<char>(0xE0 | (codePoint >> 12));
+					chars_[charCount_++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+					chars_[charCount_++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+				} else {
+					chars_[charCount_++] = static_cast<char>(0xF0 | (codePoint >> 18));
+					chars_[charCount_++] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+					chars_[charCount_++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+					chars_[charCount_++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+				}
+			}
+
+			constexpr uint32_t _ReadHex()
+			{
+				if (size_ - pos_ < 5) {
+					_StaticThrow("Invalid unicode escape", pos_);
+				}
+				uint32_t value = 0;
+				for (size_t i = 1; i <= 4; i++) {
+					const int digit = _HexValue(text_[pos_ + i]);
+					if (digit < 0) {
+						_StaticThrow("Invalid unicode escape", pos_);
+					}
+					value = (value << 4) | static_cast<uint32_t>(digit);
+				}
+				pos_ += 5;
+				return value;
+			}
+
+			// Unescapes the string at pos_ onto the end of chars_. An escape is never
+			// shorter than what it stands for, so chars_ cannot outgrow the text.
+			constexpr void _ParseString()
+			{
+				pos_++;
+				for (;;) {
+					if (pos_ == size_) {
+						_StaticThrow("Unterminated string", pos_);
+					}
+					const char ch = text_[pos_];
+					if (ch == '\"') {
+						pos_++;
+						return;
+					} else if (ch != '\\') {
+						chars_[charCount_++] = ch;
+						pos_++;
+						continue;
+					}
+					pos_++;
+					if (pos_ == size_) {
+						_StaticThrow("Unterminated string", pos_);
+					}
+					if (text_[pos_] != 'u') {
+						chars_[charCount_++] = _GetEscapeChar(text_[pos_]);
+						pos_++;
+						continue;
+					}
+					uint32_t codePoint = _ReadHex();
+					if (codePoint >= 0xD800 && codePoint <= 0xDBFF && size_ - pos_ >= 6 && text_[pos_] == '\\' && text_[pos_ + 1] == 'u') {
+						pos_++;
+						const uint32_t low = _ReadHex();
+						if (low >= 0xDC00 && low <= 0xDFFF) {
+							codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						} else {
+							_Append(codePoint);
+							codePoint = low;
+						}
+					}
+					_Append(codePoint);
+				}
+			}
+
+			// Only checks the syntax and picks the type, like JSONParser: integers that fit
+			// in int64_t are INTEGER or LONG, anything else DOUBLE.
+			constexpr void _ParseNumber(_StaticNode &node)
+			{
+				const auto start = pos_;
+				if (text_[pos_] != '-' && !_IsDigit(text_[pos_])) {
+					_StaticThrow("Invalid value", pos_);
+				}
+				if (text_[pos_] == '-') {
+					pos_++;
+				}
+				const auto digits = pos_;
+				while (pos_ != size_ && _IsDigit(text_[pos_])) {
+					pos_++;
+				}
+				const auto count = pos_ - digits;
+				if (count == 0 || (count > 1 && text_[digits] == '0')) {
+					_StaticThrow("Invalid number", start);
+				}
+				if (pos_ != size_ && text_[pos_] == '.') {
+					pos_++;
+					const auto fraction = pos_;
+					while (pos_ != size_ && _IsDigit(text_[pos_])) {
+						pos_++;
+					}
+					if (pos_ == fraction) {
+						_StaticThrow("Invalid number", start);
+					}
+				}
+				if (pos_ != size_ && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+					pos_++;
+					if (pos_ != size_ && (text_[pos_] == '+' || text_[pos_] == '-')) {
+						pos_++;
+					}
+					const auto power = pos_;
+					while (pos_ != size_ && _IsDigit(text_[pos_])) {
+						pos_++;
+					}
+					if (pos_ == power) {
+						_StaticThrow("Invalid number", start);
+					}
+				}
+				if (pos_ != size_ && (text_[pos_] == '.' || text_[pos_] == 'e' || text_[pos_] == 'E' || text_[pos_] == '+' || text_[pos_] == '-')) {
+					_StaticThrow("Invalid number", start);
+				}
+				node.count = static_cast<uint32_t>(pos_ - start);
+				for (auto pos = start; pos < pos_; pos++) {
+					chars_[charCount_++] = text_[pos];
+				}
+				const auto scan = _StaticScan(std::string_view(text_ + start, pos_ - start));
+				node.type = ItemType::DOUBLE;
+				if (scan.integral && scan.significant <= 19 && scan.mantissa <= (scan.negative ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX))) {
+					const auto value = scan.negative ? static_cast<int64_t>(0 - scan.mantissa) : static_cast<int64_t>(scan.mantissa);
+					node.type = (value >= INT_MIN && value <= INT_MAX) ? ItemType::INTEGER : ItemType::LONG;
+				}
+			}
+	};
+
+	template <size_t _Nodes, size_t _Size>
+	constexpr JSONStatic<_StaticNodes(_Nodes, _Size), _Size> ParseStatic(const char (&text)[_Size])
+	{
+		// The text ends at the terminating null, or at the end of a char array without one.
+		size_t size = 0;
+		while (size < _Size && text[size] != '\0') {
+			size++;
+		}
+		JSONStatic<_StaticNodes(_Nodes, _Size), _Size> document{};
+		_StaticParser<_StaticNodes(_Nodes, _Size), _Size> parser(text, size, document.nodes_, document.chars_);
+		parser.parse();
+		document.nodeCount_ = parser.nodeCount();
+		document.charCount_ = parser.charCount();
+		return document;
+	}
+}
+constexpr CU::_StaticDigits CU::_StaticScan(const std::string_view &text) noexcept
+{
+	_StaticDigits digits{};
+	size_t pos = 0;
+	if (text[pos] == '-') {
+		digits.negative = true;
+		pos++;
+	}
+	bool fraction = false;
+	for (; pos < text.size() && text[pos] != 'e' && text[pos] != 'E'; pos++) {
+		if (text[pos] == '.') {
+			fraction = true;
+			digits.integral = false;
+		} else if (digits.significant < 19) {
+			digits.mantissa = digits.mantissa * 10 + static_cast<uint64_t>(text[pos] - '0');
+			if (digits.mantissa != 0) {
+				digits.significant++;
+			}
+			digits.exponent -= fraction ? 1 : 0;
+		} else {
+			digits.significant++;
+			digits.exponent += fraction ? 0 : 1;
+		}
+	}
+	if (pos < text.size()) {
+		digits.integral = false;
+		pos++;
+		bool negativeExponent = false;
+		if (text[pos] == '+' || text[pos] == '-') {
+			negativeExponent = (text[pos] == '-');
+			pos++;
+		}
+		int value = 0;
+		for (; pos < text.size(); pos++) {
+			value = (value < 10000) ? value * 10 + (text[pos] - '0') : value;
+		}
+		digits.exponent += negativeExponent ? -value : value;
+	}
+	return digits;
+}
+
+constexpr CU::JSONStaticView::JSONStaticView() noexcept : nodes_(nullptr), chars_(nullptr), index_(0) { }
+
+constexpr CU::JSONStaticView::JSONStaticView(const _StaticNode* nodes, const char* chars, const size_t &index) noexcept :
+	nodes_(nodes),
+	chars_(chars),
+	index_(index)
+{ }
+
+constexpr CU::ItemType CU::JSONStaticView::type() const noexcept
+{
+	if (nodes_ == nullptr) {
+		return ItemType::ITEM_NULL;
+	}
+	return _Node().type;
+}
+
+constexpr size_t CU::JSONStaticView::size() const noexcept
+{
+	switch (type()) {
+		case ItemType::STRING:
+		case ItemType::ARRAY:
+		case ItemType::OBJECT:
+			return _Node().count;
+		default:
+			break;
+	}
+	return 0;
+}
+
+constexpr bool CU::JSONStaticView::toBoolean() const noexcept
+{
+	if (type() == ItemType::BOOLEAN) {
+		return (_Node().count != 0);
+	}
+	return {};
+}
+
+constexpr int CU::JSONStaticView::toInt() const noexcept
+{
+	if (type() == ItemType::INTEGER) {
+		const auto digits = _StaticScan(_Text());
+		return static_cast<int>(digits.negative ? 0 - digits.mantissa : digits.mantissa);
+	}
+	return {};
+}
+
+constexpr int64_t CU::JSONStaticView::toLong() const noexcept
+{
+	if (type() == ItemType::LONG) {
+		const auto digits = _StaticScan(_Text());
+		return static_cast<int64_t>(digits.negative ? 0 - digits.mantissa : digits.mantissa);
+	}
+	return {};
+}
+
+constexpr double CU::JSONStaticView::toDouble() const
+{
+	// The fast path of Clinger's algorithm: digits that fit in 2^53 scaled by a power of
+	// ten up to 22 are exact in one multiplication or division.
+	if (type() == ItemType::DOUBLE) {
+		const auto digits = _StaticScan(_Text());
+		if (digits.significant > 19 || digits.mantissa > (uint64_t(1) << 53) || digits.exponent < -22 || digits.exponent > 22) {
+			return _StaticDouble(_Text());
+		}
+		double power = 1.0;
+		for (int i = 0; i < (digits.exponent < 0 ? -digits.exponent : digits.exponent); i++) {
+			power *= 10.0;
+		}
+		const double value = static_cast<double>(digits.mantissa);
+		const double number = (digits.exponent < 0) ? value / power : value * power;
+		return digits.negative ? -number : number;
+	}
+	return {};
+}
+
+constexpr std::string_view CU::JSONStaticView::toString() const noexcept
+{
+	if (type() == ItemType::STRING) {
+		return _Text();
+	}
+	return {};
+}
+
+constexpr CU::JSONStaticView CU::JSONStaticView::at(const size_t &pos) const
+{
+	if ((type() != ItemType::ARRAY && type() != ItemType::OBJECT) || pos >= _Node().count) {
+		throw JSONExcept("Position out of bound");
+	}
+	auto index = index_ + 1;
+	for (size_t skip = 0; skip < pos; skip++) {
+		index = nodes_[index].end;
+	}
+	return JSONStaticView(nodes_, chars_, index);
+}
+
+constexpr CU::JSONStaticView CU::JSONStaticView::at(const std::string_view &key) const
+{
+	const auto index = _Find(key);
+	if (index == 0) {
+		throw JSONExcept("Key not found");
+	}
+	return JSONStaticView(nodes_, chars_, index);
+}
+
+constexpr bool CU::JSONStaticView::contains(const std::string_view &key) const noexcept
+{
+	return (_Find(key) != 0);
+}
+
+constexpr std::string_view CU::JSONStaticView::key(const size_t &pos) const
+{
+	if (type() != ItemType::OBJECT) {
+		throw JSONExcept("Item is not a JSONObject");
+	}
+	const auto &node = nodes_[at(pos).index_];
+	return std::string_view(chars_ + node.key, node.keySize);
+}
+
+constexpr const CU::_StaticNode &CU::JSONStaticView::_Node() const noexcept
+{
+	return nodes_[index_];
+}
+
+constexpr std::string_view CU::JSONStaticView::_Text() const noexcept
+{
+	const auto &node = _Node();
+	return std::string_view(chars_ + node.key + node.keySize, node.count);
+}
+
+// The root is never a member, so 0 means not found. Duplicated keys find the last value,
+// like JSONParser keeps.
+constexpr size_t CU::JSONStaticView::_Find(const std::string_view &key) const noexcept
+{
+	if (type() != ItemType::OBJECT) {
+		return 0;
+	}
+	const auto &object = _Node();
+	size_t found = 0;
+	for (auto index = index_ + 1; index < object.end; index = nodes_[index].end) {
+		const auto &node = nodes_[index];
+		if (std::string_view(chars_ + node.key, node.keySize) == key) {
+			found = index;
+		}
+	}
+	return found;
+}
+
+#endif // _CU_JSONSTATIC_
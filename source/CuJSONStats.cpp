@@ -0,0 +1,215 @@
+#include "CuJSONStats.h"
+#include <atomic>
+
+namespace CU
+{
+	namespace
+	{
+		struct _GlobalStats
+		{
+			std::atomic<uint64_t> parseCalls;
+			std::atomic<uint64_t> serializeCalls;
+			std::atomic<uint64_t> bytesParsed;
+			std::atomic<uint64_t> bytesSerialized;
+			std::atomic<uint64_t> bytesRescanned;
+			std::atomic<uint64_t> nodeCount[8];
+			std::atomic<uint64_t> maxDepth;
+			std::atomic<uint64_t> allocCount;
+			std::atomic<uint64_t> allocBytes;
+			std::atomic<uint64_t> escapeCount;
+			std::atomic<uint64_t> stringBytes;
+			std::atomic<uint64_t> parseNanos;
+			std::atomic<uint64_t> serializeNanos;
+		};
+
+		struct _ThreadStats
+		{
+			JSONStats local;
+			JSONStatsScope* scope;
+			uint64_t depth[2];
+		};
+
+		_GlobalStats globalStats{};
+		thread_local _ThreadStats threadStats{};
+
+		void _AtomicMax(std::atomic<uint64_t> &target, const uint64_t &value)
+		{
+			auto current = target.load(std::memory_order_relaxed);
+			while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+		}
+
+		void _MergeGlobal(const JSONStats &stats)
+		{
+			globalStats.parseCalls.fetch_add(stats.parseCalls, std::memory_order_relaxed);
+			globalStats.serializeCalls.fetch_add(stats.serializeCalls, std::memory_order_relaxed);
+			globalStats.bytesParsed.fetch_add(stats.bytesParsed, std::memory_order_relaxed);
+			globalStats.bytesSerialized.fetch_add(stats.bytesSerialized, std::memory_order_relaxed);
+			globalStats.bytesRescanned.fetch_add(stats.bytesRescanned, std::memory_order_relaxed);
+			for (size_t i = 0; i < 8; i++) {
+				globalStats.nodeCount[i].fetch_add(stats.nodeCount[i], std::memory_order_relaxed);
+			}
+			_AtomicMax(globalStats.maxDepth, stats.maxDepth);
+			globalStats.allocCount.fetch_add(stats.allocCount, std::memory_order_relaxed);
+			globalStats.allocBytes.fetch_add(stats.allocBytes, std::memory_order_relaxed);
+			globalStats.escapeCount.fetch_add(stats.escapeCount, std::memory_order_relaxed);
+			globalStats.stringBytes.fetch_add(stats.stringBytes, std::memory_order_relaxed);
+			globalStats.parseNanos.fetch_add(stats.parseNanos, std::memory_order_relaxed);
+			globalStats.serializeNanos.fetch_add(stats.serializeNanos, std::memory_order_relaxed);
+		}
+	}
+}
+
+void CU::JSONStats::merge(const JSONStats &other)
+{
+	parseCalls += other.parseCalls;
+	serializeCalls += other.serializeCalls;
+	bytesParsed += other.bytesParsed;
+	bytesSerialized += other.bytesSerialized;
+	bytesRescanned += other.bytesRescanned;
+	for (size_t i = 0; i < 8; i++) {
+		nodeCount[i] += other.nodeCount[i];
+	}
+	maxDepth = std::max(maxDepth, other.maxDepth);
+	allocCount += other.allocCount;
+	allocBytes += other.allocBytes;
+	escapeCount += other.escapeCount;
+	stringBytes += other.stringBytes;
+	parseNanos += other.parseNanos;
+	serializeNanos += other.serializeNanos;
+}
+
+CU::JSONObject CU::JSONStats::toObject() const
+{
+	static const char* typeNames[] = {"null", "boolean", "integer", "long", "double", "string", "array", "object"};
+
+	JSONObject nodes{};
+	for (size_t i = 0; i < 8; i++) {
+		nodes.add(typeNames[i], static_cast<int64_t>(nodeCount[i]));
+	}
+	JSONObject object{};
+	object.add("parseCalls", static_cast<int64_t>(parseCalls));
+	object.add("serializeCalls", static_cast<int64_t>(serializeCalls));
+	object.add("bytesParsed", static_cast<int64_t>(bytesParsed));
+	object.add("bytesSerialized", static_cast<int64_t>(bytesSerialized));
+	object.add("bytesRescanned", static_cast<int64_t>(bytesRescanned));
+	object.add("nodeCount", nodes);
+	object.add("maxDepth", static_cast<int64_t>(maxDepth));
+	object.add("allocCount", static_cast<int64_t>(allocCount));
+	object.add("allocBytes", static_cast<int64_t>(allocBytes));
+	object.add("escapeCount", static_cast<int64_t>(escapeCount));
+	object.add("stringBytes", static_cast<int64_t>(stringBytes));
+	object.add("parseNanos", static_cast<int64_t>(parseNanos));
+	object.add("serializeNanos", static_cast<int64_t>(serializeNanos));
+	return object;
+}
+
+CU::JSONStatsScope::JSONStatsScope(JSONStats &stats) : stats_(std::addressof(stats)), prev_(threadStats.scope)
+{
+	threadStats.scope = this;
+}
+
+CU::JSONStatsScope::~JSONStatsScope()
+{
+	threadStats.scope = prev_;
+}
+
+CU::JSONStats CU::GetGlobalStats()
+{
+	JSONStats stats{};
+	stats.parseCalls = globalStats.parseCalls.load(std::memory_order_relaxed);
+	stats.serializeCalls = globalStats.serializeCalls.load(std::memory_order_relaxed);
+	stats.bytesParsed = globalStats.bytesParsed.load(std::memory_order_relaxed);
+	stats.bytesSerialized = globalStats.bytesSerialized.load(std::memory_order_relaxed);
+	stats.bytesRescanned = globalStats.bytesRescanned.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < 8; i++) {
+		stats.nodeCount[i] = globalStats.nodeCount[i].load(std::memory_order_relaxed);
+	}
+	stats.maxDepth = globalStats.maxDepth.load(std::memory_order_relaxed);
+	stats.allocCount = globalStats.allocCount.load(std::memory_order_relaxed);
+	stats.allocBytes = globalStats.allocBytes.load(std::memory_order_relaxed);
+	stats.escapeCount = globalStats.escapeCount.load(std::memory_order_relaxed);
+	stats.stringBytes = globalStats.stringBytes.load(std::memory_order_relaxed);
+	stats.parseNanos = globalStats.parseNanos.load(std::memory_order_relaxed);
+	stats.serializeNanos = globalStats.serializeNanos.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void CU::ResetGlobalStats()
+{
+	globalStats.parseCalls.store(0, std::memory_order_relaxed);
+	globalStats.serializeCalls.store(0, std::memory_order_relaxed);
+	globalStats.bytesParsed.store(0, std::memory_order_relaxed);
+	globalStats.bytesSerialized.store(0, std::memory_order_relaxed);
+	globalStats.bytesRescanned.store(0, std::memory_order_relaxed);
+	for (size_t i = 0; i < 8; i++) {
+		globalStats.nodeCount[i].store(0, std::memory_order_relaxed);
+	}
+	globalStats.maxDepth.store(0, std::memory_order_relaxed);
+	globalStats.allocCount.store(0, std::memory_order_relaxed);
+	globalStats.allocBytes.store(0, std::memory_order_relaxed);
+	globalStats.escapeCount.store(0, std::memory_order_relaxed);
+	globalStats.stringBytes.store(0, std::memory_order_relaxed);
+	globalStats.parseNanos.store(0, std::memory_order_relaxed);
+	globalStats.serializeNanos.store(0, std::memory_order_relaxed);
+}
+
+CU::_StatsPhase::_StatsPhase(const _StatsPhaseType &type, const size_t &bytes) :
+	type_(type),
+	outermost_(false),
+	begin_()
+{
+	auto &depth = threadStats.depth[static_cast<size_t>(type_)];
+	depth++;
+	outermost_ = (depth == 1);
+	auto &local = threadStats.local;
+	if (type_ == _StatsPhaseType::PARSE) {
+		local.maxDepth = std::max(local.maxDepth, depth);
+		if (outermost_) {
+			local.parseCalls++;
+			local.bytesParsed += bytes;
+		} else {
+			local.bytesRescanned += bytes;
+		}
+	} else if (outermost_) {
+		local.serializeCalls++;
+	}
+	if (outermost_) {
+		begin_ = std::chrono::steady_clock::now();
+	}
+}
+
+CU::_StatsPhase::~_StatsPhase()
+{
+	threadStats.depth[static_cast<size_t>(type_)]--;
+	if (!outermost_) {
+		return;
+	}
+	auto &local = threadStats.local;
+	const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_).count();
+	if (type_ == _StatsPhaseType::PARSE) {
+		local.parseNanos += static_cast<uint64_t>(nanos);
+	} else {
+		local.serializeNanos += static_cast<uint64_t>(nanos);
+	}
+	// A parse nested inside a serialize (or the reverse) is flushed together with the outer call.
+	if (threadStats.depth[0] != 0 || threadStats.depth[1] != 0) {
+		return;
+	}
+	for (auto scope = threadStats.scope; scope != nullptr; scope = scope->prev_) {
+		scope->stats_->merge(local);
+	}
+	_MergeGlobal(local);
+	local = JSONStats();
+}
+
+void CU::_StatsPhase::output(const size_t &bytes)
+{
+	if (outermost_) {
+		threadStats.local.bytesSerialized += bytes;
+	}
+}
+
+CU::JSONStats &CU::_LocalStats() noexcept
+{
+	return threadStats.local;
+}
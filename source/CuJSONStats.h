@@ -0,0 +1,102 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONSTATS_
+#define _CU_JSONSTATS_
+
+#include <chrono>
+#include <cstdint>
+#include "CuJSONObject.h"
+
+// Instrumentation is compiled in only when CU_JSON_STATS is defined,
+// otherwise every hook expands to nothing and JSONStats stay zero.
+
+namespace CU
+{
+	struct JSONStats
+	{
+		uint64_t parseCalls;
+		uint64_t serializeCalls;
+		uint64_t bytesParsed;
+		uint64_t bytesSerialized;
+		uint64_t bytesRescanned;
+		uint64_t nodeCount[8];
+		uint64_t maxDepth;
+		uint64_t allocCount;
+		uint64_t allocBytes;
+		uint64_t escapeCount;
+		uint64_t stringBytes;
+		uint64_t parseNanos;
+		uint64_t serializeNanos;
+
+		void merge(const JSONStats &other);
+		JSONObject toObject() const;
+	};
+
+	constexpr bool JSONStatsEnabled() noexcept
+	{
+#ifdef CU_JSON_STATS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Collects the statistics of every parse/serialize call made by the current thread
+	// while the scope is alive. Scopes may be nested, each one receives the calls made inside it.
+	class JSONStatsScope
+	{
+		public:
+			JSONStatsScope(JSONStats &stats);
+			~JSONStatsScope();
+
+			JSONStatsScope(const JSONStatsScope &) = delete;
+			JSONStatsScope &operator=(const JSONStatsScope &) = delete;
+
+		private:
+			friend class _StatsPhase;
+
+			JSONStats* stats_;
+			JSONStatsScope* prev_;
+	};
+
+	// Process-wide counters, accumulated from all threads.
+	JSONStats GetGlobalStats();
+	void ResetGlobalStats();
+
+	enum class _StatsPhaseType : uint8_t {PARSE, SERIALIZE};
+
+	// Measures one parse/serialize call. Calls nested inside a running phase of the same
+	// type (e.g. _To_Init_Val re-scanning a nested value) only add to the running one.
+	class _StatsPhase
+	{
+		public:
+			_StatsPhase(const _StatsPhaseType &type, const size_t &bytes);
+			~_StatsPhase();
+
+			void output(const size_t &bytes);
+
+		private:
+			_StatsPhaseType type_;
+			bool outermost_;
+			std::chrono::steady_clock::time_point begin_;
+	};
+
+	JSONStats &_LocalStats() noexcept;
+}
+
+#ifdef CU_JSON_STATS
+#define _CU_STATS_PHASE(type, bytes) CU::_StatsPhase _cuStatsPhase(CU::_StatsPhaseType::type, bytes)
+#define _CU_STATS_OUTPUT(bytes) _cuStatsPhase.output(bytes)
+#define _CU_STATS_ADD(field, count) (CU::_LocalStats().field += static_cast<uint64_t>(count))
+#define _CU_STATS_NODE(type) (CU::_LocalStats().nodeCount[static_cast<size_t>(type)]++)
+#define _CU_STATS_MAX(field, value) (CU::_LocalStats().field = std::max<uint64_t>(CU::_LocalStats().field, value))
+#else
+#define _CU_STATS_PHASE(type, bytes) ((void)0)
+#define _CU_STATS_OUTPUT(bytes) ((void)0)
+#define _CU_STATS_ADD(field, count) ((void)0)
+#define _CU_STATS_NODE(type) ((void)0)
+#define _CU_STATS_MAX(field, value) ((void)0)
+#endif
+
+#endif // _CU_JSONSTATS_
@@ -0,0 +1,234 @@
+#include "CuJSONWriter.h"
+#include <charconv>
+
+CU::JSONWriter::JSONWriter(std::string &buffer) :
+	buffer_(std::addressof(buffer)),
+	pending_(),
+	sink_(),
+	flushSize_(0),
+	comma_(false),
+	stack_(),
+	keyed_(false),
+	started_(false)
+{ }
+
+CU::JSONWriter::JSONWriter(const Sink &sink, const size_t &flushSize) :
+	buffer_(std::addressof(pending_)),
+	pending_(),
+	sink_(sink),
+	flushSize_(flushSize),
+	comma_(false),
+	stack_(),
+	keyed_(false),
+	started_(false)
+{
+	pending_.reserve(flushSize_);
+}
+
+// A destructor cannot pass on what the sink throws, it is lost.
+CU::JSONWriter::~JSONWriter()
+{
+	try {
+		flush();
+	} catch (...) { }
+}
+
+CU::JSONWriter &CU::JSONWriter::startObject()
+{
+	_Start('{');
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::endObject()
+{
+	_End('}');
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::startArray()
+{
+	_Start('[');
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::endArray()
+{
+	_End(']');
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::key(const std::string_view &key)
+{
+#ifndef NDEBUG
+	if (stack_.empty() || stack_.back() != '{' || keyed_) {
+		throw JSONExcept("Unexpected key");
+	}
+	keyed_ = true;
+#endif
+	if (comma_) {
+		*buffer_ += ',';
+	}
+	_AppendJSONRaw(*buffer_, key);
+	*buffer_ += ':';
+	comma_ = false;
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(std::nullptr_t)
+{
+	_Value();
+	*buffer_ += "null";
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const bool &value)
+{
+	_Value();
+	*buffer_ += value ? "true" : "false";
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const double &value)
+{
+	_Value();
+	_AppendJSONDouble(*buffer_, value);
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const char* value)
+{
+	return this->value(std::string_view(value));
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const std::string &value)
+{
+	return this->value(std::string_view(value));
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const std::string_view &value)
+{
+	_Value();
+	_AppendJSONRaw(*buffer_, value);
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const JSONItem &value)
+{
+	_Value();
+	buffer_->reserve(buffer_->size() + value.serializedSize());
+	_WriteRaw(value, *buffer_);
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const JSONArray &value)
+{
+	_Value();
+	buffer_->reserve(buffer_->size() + value.serializedSize());
+	_WriteRaw(value, *buffer_);
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::value(const JSONObject &value)
+{
+	_Value();
+	buffer_->reserve(buffer_->size() + value.serializedSize());
+	_WriteRaw(value, *buffer_);
+	_Flow();
+	return *this;
+}
+
+size_t CU::JSONWriter::depth() const noexcept
+{
+	return stack_.size();
+}
+
+bool CU::JSONWriter::complete() const noexcept
+{
+	return (started_ && stack_.empty());
+}
+
+void CU::JSONWriter::flush()
+{
+	if (sink_ && !pending_.empty()) {
+		sink_(pending_);
+		pending_.clear();
+	}
+}
+
+// Starts the next document; text already written stays in the buffer or the sink.
+void CU::JSONWriter::reset()
+{
+	comma_ = false;
+	stack_.clear();
+	keyed_ = false;
+	started_ = false;
+}
+
+CU::JSONWriter &CU::JSONWriter::_Signed(const int64_t &value)
+{
+	_Value();
+	_AppendJSONInteger(*buffer_, value);
+	_Flow();
+	return *this;
+}
+
+CU::JSONWriter &CU::JSONWriter::_Unsigned(const uint64_t &value)
+{
+	_Value();
+	char chars[24];
+	const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+	buffer_->append(chars, result.ptr);
+	_Flow();
+	return *this;
+}
+
+void CU::JSONWriter::_Value()
+{
+#ifndef NDEBUG
+	if (stack_.empty() ? started_ : (stack_.back() == '{' && !keyed_)) {
+		throw JSONExcept(stack_.empty() ? "Document already complete" : "Expected a key");
+	}
+	keyed_ = false;
+#endif
+	if (comma_) {
+		*buffer_ += ',';
+	}
+	comma_ = true;
+	started_ = true;
+}
+
+void CU::JSONWriter::_Start(const char &open)
+{
+	_Value();
+	*buffer_ += open;
+	stack_.emplace_back(open);
+	comma_ = false;
+}
+
+void CU::JSONWriter::_End(const char &close)
+{
+#ifndef NDEBUG
+	if (stack_.empty() || stack_.back() != ((close == '}') ? '{' : '[') || keyed_) {
+		throw JSONExcept(std::string("Unexpected ") + ((close == '}') ? "endObject" : "endArray"));
+	}
+#endif
+	*buffer_ += close;
+	if (!stack_.empty()) {
+		stack_.pop_back();
+	}
+	comma_ = true;
+	_Flow();
+}
+
+void CU::JSONWriter::_Flow()
+{
+	if (sink_ && pending_.size() >= flushSize_) {
+		flush();
+	}
+}
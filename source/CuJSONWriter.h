@@ -0,0 +1,81 @@
+// CuJSONObject V1 by chenzyadb@github.com
+// Based on C++17 STL (MSVC).
+
+#ifndef _CU_JSONWRITER_
+#define _CU_JSONWRITER_
+
+#include "CuJSONObject.h"
+
+namespace CU
+{
+	// Writes JSON text as it is described, without building a tree first. Strings and numbers
+	// come out exactly as toString() writes them, and a JSONItem can be embedded as a whole.
+	// The text goes straight into a caller's string, or is handed to a sink in chunks of about
+	// flushSize bytes; flush() passes on the rest, and so does the destructor, which has to
+	// drop an exception of the sink: call flush() first to see it. Builds without NDEBUG
+	// check the nesting and throw JSONExcept on a misplaced key, value or end.
+	class JSONWriter
+	{
+		public:
+			typedef std::function<void(const std::string_view &text)> Sink;
+
+			JSONWriter(std::string &buffer);
+			JSONWriter(const Sink &sink, const size_t &flushSize = 65536);
+			~JSONWriter();
+
+			JSONWriter(const JSONWriter &) = delete;
+			JSONWriter &operator=(const JSONWriter &) = delete;
+
+			JSONWriter &startObject();
+			JSONWriter &endObject();
+			JSONWriter &startArray();
+			JSONWriter &endArray();
+			JSONWriter &key(const std::string_view &key);
+			JSONWriter &value(std::nullptr_t);
+			JSONWriter &value(const bool &value);
+			// Any integer type but bool, unsigned ones above INT64_MAX included.
+			template <typename _Integer, typename = std::enable_if_t<std::is_integral_v<_Integer> && !std::is_same_v<_Integer, bool>>>
+			JSONWriter &value(const _Integer &value)
+			{
+				if constexpr (std::is_signed_v<_Integer>) {
+					return _Signed(static_cast<int64_t>(value));
+				} else {
+					return _Unsigned(static_cast<uint64_t>(value));
+				}
+			}
+			JSONWriter &value(const double &value);
+			JSONWriter &value(const char* value);
+			JSONWriter &value(const std::string &value);
+			JSONWriter &value(const std::string_view &value);
+			JSONWriter &value(const JSONItem &value);
+			JSONWriter &value(const JSONArray &value);
+			JSONWriter &value(const JSONObject &value);
+
+			size_t depth() const noexcept;
+			bool complete() const noexcept;
+			void flush();
+			void reset();
+
+		private:
+			std::string* buffer_;
+			std::string pending_;
+			Sink sink_;
+			size_t flushSize_;
+			// Whether a ',' goes before the next value.
+			bool comma_;
+			// Open containers, '{' or '['. keyed_ (a key waiting for its value) is only kept
+			// by the nesting checks.
+			std::vector<char> stack_;
+			bool keyed_;
+			bool started_;
+
+			JSONWriter &_Signed(const int64_t &value);
+			JSONWriter &_Unsigned(const uint64_t &value);
+			void _Value();
+			void _Start(const char &open);
+			void _End(const char &close);
+			void _Flow();
+	};
+}
+
+#endif // _CU_JSONWRITER_
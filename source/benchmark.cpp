@@ -0,0 +1,394 @@
+// CuJSONObject benchmark, corpora modeled after nativejson-benchmark by miloyip.
+// parse_reuse parses into a warmed up JSONDocument with a reused JSONParser.
+// Prints one JSON object per line: {"corpus", "operation", "bytes", "iterations", "seconds", "mb_per_s", "allocs", "alloc_bytes"}.
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstring>
+#include "CuJSONObject.h"
+#include "CuJSONStats.h"
+#include "CuJSONParser.h"
+
+namespace
+{
+	std::atomic<uint64_t> allocCount(0);
+	std::atomic<uint64_t> allocBytes(0);
+
+	struct AllocSnapshot
+	{
+		uint64_t count;
+		uint64_t bytes;
+	};
+
+	AllocSnapshot TakeAllocSnapshot()
+	{
+		AllocSnapshot snapshot{};
+		snapshot.count = allocCount.load(std::memory_order_relaxed);
+		snapshot.bytes = allocBytes.load(std::memory_order_relaxed);
+		return snapshot;
+	}
+
+	void* CountedAlloc(size_t size)
+	{
+		allocCount.fetch_add(1, std::memory_order_relaxed);
+		allocBytes.fetch_add(size, std::memory_order_relaxed);
+		void* ptr = std::malloc(size == 0 ? 1 : size);
+		if (ptr == nullptr) {
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+}
+
+void* operator new(size_t size)
+{
+	return CountedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+	return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned forms.
+void* operator new(size_t size, std::align_val_t align)
+{
+	allocCount.fetch_add(1, std::memory_order_relaxed);
+	allocBytes.fetch_add(size, std::memory_order_relaxed);
+	void* ptr = nullptr;
+	if (posix_memalign(&ptr, std::max(sizeof(void*), static_cast<size_t>(align)), size == 0 ? 1 : size) != 0) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace
+{
+	struct BenchConfig
+	{
+		double scale;
+		double minSeconds;
+		std::string corpus;
+		std::string dumpDir;
+		bool pool;
+	};
+
+	// Formats a double the way the corpora of nativejson-benchmark do (up to 17 significant digits).
+	std::string FormatDouble(const double &value)
+	{
+		char buffer[32]{};
+		snprintf(buffer, sizeof(buffer), "%.17g", value);
+		return std::string(buffer);
+	}
+
+	// canada.json: a single GeoJSON feature made of long arrays of [lon, lat] pairs.
+	std::string MakeCanadaCorpus(const double &scale)
+	{
+		std::mt19937_64 rng(20240314);
+		std::uniform_real_distribution<double> lonDist(-141.0, -52.6);
+		std::uniform_real_distribution<double> latDist(41.7, 83.1);
+		const size_t polygons = std::max<size_t>(1, static_cast<size_t>(480 * scale));
+		const size_t points = 115;
+
+		std::string text("{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},");
+		text += "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+		for (size_t polygon = 0; polygon < polygons; polygon++) {
+			text += (polygon == 0) ? "[" : ",[";
+			for (size_t point = 0; point < points; point++) {
+				text += (point == 0) ? "[" : ",[";
+				text += FormatDouble(lonDist(rng)) + "," + FormatDouble(latDist(rng)) + "]";
+			}
+			text += "]";
+		}
+		text += "]}}]}";
+		return text;
+	}
+
+	// twitter.json: search results made of string-heavy status objects with nested user/entities.
+	std::string MakeTwitterCorpus(const double &scale)
+	{
+		static const char* words[] = {
+			"RT", "@aym0566x", "\\u540d\\u524d", "\\u6027\\u5225", "json", "parser", "\\\"quoted\\\"",
+			"http:\\/\\/t.co\\/abc", "line\\nbreak", "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf",
+			"benchmark", "#hashtag", "tab\\tstop", "performance", "latency", "throughput"
+		};
+		constexpr size_t wordCount = sizeof(words) / sizeof(words[0]);
+		std::mt19937_64 rng(20240315);
+		std::uniform_int_distribution<size_t> wordDist(0, wordCount - 1);
+		std::uniform_int_distribution<int64_t> idDist(100000000000000000LL, 999999999999999999LL);
+		std::uniform_int_distribution<int> countDist(0, 50000);
+		const size_t statuses = std::max<size_t>(1, static_cast<size_t>(450 * scale));
+
+		const auto makeSentence = [&](const size_t &length) -> std::string {
+			std::string sentence{};
+			for (size_t i = 0; i < length; i++) {
+				if (i != 0) {
+					sentence += ' ';
+				}
+				sentence += words[wordDist(rng)];
+			}
+			return sentence;
+		};
+
+		std::string text("{\"statuses\":[");
+		for (size_t status = 0; status < statuses; status++) {
+			const auto id = std::to_string(idDist(rng));
+			if (status != 0) {
+				text += ",";
+			}
+			text += "{\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"ja\"},";
+			text += "\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":" + id + ",\"id_str\":\"" + id + "\",";
+			text += "\"text\":\"" + makeSentence(14) + "\",";
+			text += "\"source\":\"<a href=\\\"https:\\/\\/mobile.twitter.com\\\" rel=\\\"nofollow\\\">Mobile Web (M2)<\\/a>\",";
+			text += "\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_screen_name\":null,";
+			text += "\"user\":{\"id\":" + std::to_string(countDist(rng)) + ",\"name\":\"" + makeSentence(2) + "\",";
+			text += "\"screen_name\":\"" + makeSentence(1) + "\",\"location\":\"" + makeSentence(3) + "\",";
+			text += "\"description\":\"" + makeSentence(20) + "\",\"url\":null,";
+			text += "\"entities\":{\"description\":{\"urls\":[]}},\"protected\":false,";
+			text += "\"followers_count\":" + std::to_string(countDist(rng)) + ",";
+			text += "\"friends_count\":" + std::to_string(countDist(rng)) + ",";
+			text += "\"verified\":false,\"lang\":\"ja\",\"profile_background_color\":\"C0DEED\"},";
+			text += "\"geo\":null,\"coordinates\":null,\"place\":null,\"contributors\":null,";
+			text += "\"retweet_count\":" + std::to_string(countDist(rng)) + ",\"favorite_count\":0,";
+			text += "\"entities\":{\"hashtags\":[],\"symbols\":[],\"urls\":[],\"user_mentions\":[{\"screen_name\":\"aym0566x\",";
+			text += "\"name\":\"" + makeSentence(2) + "\",\"id\":586671909,\"indices\":[3,12]}]},";
+			text += "\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}";
+		}
+		text += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815700,";
+		text += "\"query\":\"%E4%B8%80\",\"count\":" + std::to_string(statuses) + ",\"since_id\":0}}";
+		return text;
+	}
+
+	// citm_catalog.json: id-keyed lookup tables, events and performances mixing every value type.
+	std::string MakeCitmCorpus(const double &scale)
+	{
+		std::mt19937_64 rng(20240316);
+		std::uniform_int_distribution<int> idDist(100000000, 999999999);
+		std::uniform_int_distribution<int> smallDist(0, 400);
+		const size_t events = std::max<size_t>(1, static_cast<size_t>(900 * scale));
+		const size_t performances = std::max<size_t>(1, static_cast<size_t>(1200 * scale));
+
+		std::string text("{\"areaNames\":{");
+		for (size_t area = 0; area < events; area++) {
+			if (area != 0) {
+				text += ",";
+			}
+			text += "\"" + std::to_string(idDist(rng)) + "\":\"Arri\xc3\xa8re-sc\xc3\xa8ne " + std::to_string(area) + "\"";
+		}
+		text += "},\"events\":{";
+		for (size_t event = 0; event < events; event++) {
+			const auto id = std::to_string(idDist(rng));
+			if (event != 0) {
+				text += ",";
+			}
+			text += "\"" + id + "\":{\"description\":null,\"id\":" + id + ",\"logo\":\"\\/images\\/UE0AAAAACEKo6QAAAAVDSVRN\",";
+			text += "\"name\":\"Orchestre Philharmonique de Radio France\",\"subTopicIds\":[337184283,337184263,337184267],";
+			text += "\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[324846099,107888604]}";
+		}
+		text += "},\"performances\":[";
+		for (size_t performance = 0; performance < performances; performance++) {
+			if (performance != 0) {
+				text += ",";
+			}
+			text += "{\"eventId\":" + std::to_string(idDist(rng)) + ",\"id\":" + std::to_string(idDist(rng)) + ",";
+			text += "\"logo\":null,\"name\":null,\"prices\":[";
+			const int prices = 1 + smallDist(rng) % 4;
+			for (int price = 0; price < prices; price++) {
+				if (price != 0) {
+					text += ",";
+				}
+				text += "{\"amount\":" + std::to_string(90250 + smallDist(rng) * 100) + ",";
+				text += "\"audienceSubCategoryId\":337100890,\"seatCategoryId\":" + std::to_string(idDist(rng)) + "}";
+			}
+			text += "],\"seatCategories\":[{\"areas\":[{\"areaId\":205705999,\"blockIds\":[]},{\"areaId\":205705998,\"blockIds\":[]}],";
+			text += "\"seatCategoryId\":338937295}],\"seatMapImage\":null,\"start\":1378922400000,";
+			text += "\"venueCode\":\"PLEYEL_PLEYEL\",\"ratio\":" + FormatDouble(smallDist(rng) / 400.0) + ",\"soldOut\":false}";
+		}
+		text += "],\"seatCategoryNames\":{\"338937295\":\"1\\u00e8re cat\\u00e9gorie\"},\"subjectNames\":{},";
+		text += "\"topicNames\":{\"107888604\":\"Activit\\u00e9\",\"324846099\":\"Premi\\u00e8res repr\\u00e9sentations\"},";
+		text += "\"venueNames\":{\"PLEYEL_PLEYEL\":\"Salle Pleyel\"}}";
+		return text;
+	}
+
+	struct BenchResult
+	{
+		size_t iterations;
+		double seconds;
+		AllocSnapshot allocs;
+	};
+
+	// Runs the operation until minSeconds elapsed (at least 3 times) and keeps the fastest run.
+	template <typename _Func>
+	BenchResult RunBench(const double &minSeconds, _Func &&func)
+	{
+		BenchResult result{};
+		result.seconds = -1.0;
+		double elapsed = 0.0;
+		while (result.iterations < 3 || elapsed < minSeconds) {
+			const auto allocBegin = TakeAllocSnapshot();
+			const auto timeBegin = std::chrono::steady_clock::now();
+			func();
+			const auto timeEnd = std::chrono::steady_clock::now();
+			const auto allocEnd = TakeAllocSnapshot();
+			const double seconds = std::chrono::duration<double>(timeEnd - timeBegin).count();
+			if (result.seconds < 0.0 || seconds < result.seconds) {
+				result.seconds = seconds;
+			}
+			result.allocs.count = allocEnd.count - allocBegin.count;
+			result.allocs.bytes = allocEnd.bytes - allocBegin.bytes;
+			result.iterations++;
+			elapsed += seconds;
+		}
+		return result;
+	}
+
+	void PrintResult(const std::string &corpus, const std::string &operation, const size_t &bytes, const BenchResult &result)
+	{
+		char throughput[32]{};
+		snprintf(throughput, sizeof(throughput), "%.3f", (bytes / (1024.0 * 1024.0)) / result.seconds);
+		char seconds[32]{};
+		snprintf(seconds, sizeof(seconds), "%.9f", result.seconds);
+		std::cout << "{\"corpus\":\"" << corpus << "\",\"operation\":\"" << operation << "\",\"bytes\":" << bytes
+			<< ",\"iterations\":" << result.iterations << ",\"seconds\":" << seconds << ",\"mb_per_s\":" << throughput
+			<< ",\"allocs\":" << result.allocs.count << ",\"alloc_bytes\":" << result.allocs.bytes << "}" << std::endl;
+	}
+
+	void BenchCorpus(const BenchConfig &config, const std::string &corpus, const std::string &text)
+	{
+		// With --pool every value is allocated from a pool kept across iterations.
+		std::pmr::unsynchronized_pool_resource pool{};
+		CU::JSONMemoryScope scope(config.pool ? static_cast<std::pmr::memory_resource*>(&pool) : CU::GetMemoryResource());
+
+		if (!config.dumpDir.empty()) {
+			std::ofstream file(config.dumpDir + "/" + corpus + ".json", std::ios::binary);
+			file << text;
+		}
+
+		const CU::JSONObject parsed(text);
+		const auto compact = parsed.toString();
+		const auto pretty = parsed.toFormatedString();
+
+		auto result = RunBench(config.minSeconds, [&]() {
+			CU::JSONObject object(text);
+		});
+		PrintResult(corpus, "parse", text.size(), result);
+
+		CU::JSONParser parser{};
+		CU::JSONDocument document{};
+		parser.parse(text, document);
+		result = RunBench(config.minSeconds, [&]() {
+			parser.parse(text, document);
+		});
+		PrintResult(corpus, "parse_reuse", text.size(), result);
+
+		result = RunBench(config.minSeconds, [&]() {
+			auto output = parsed.toString();
+		});
+		PrintResult(corpus, "stringify", compact.size(), result);
+
+		result = RunBench(config.minSeconds, [&]() {
+			auto output = parsed.toFormatedString();
+		});
+		PrintResult(corpus, "prettify", pretty.size(), result);
+
+		result = RunBench(config.minSeconds, [&]() {
+			CU::JSONObject object(text);
+			auto output = object.toString();
+		});
+		PrintResult(corpus, "roundtrip", text.size(), result);
+	}
+
+	void PrintUsage(const char* program)
+	{
+		std::cerr << "Usage: " << program << " [--scale N] [--min-time SECONDS] [--corpus canada|twitter|citm] [--dump-dir DIR] [--pool]" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchConfig config{};
+	config.scale = 1.0;
+	config.minSeconds = 0.5;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg(argv[i]);
+		if (arg == "--help" || arg == "-h") {
+			PrintUsage(argv[0]);
+			return 0;
+		} else if (arg == "--pool") {
+			config.pool = true;
+		} else if (i + 1 >= argc) {
+			PrintUsage(argv[0]);
+			return 1;
+		} else if (arg == "--scale") {
+			config.scale = atof(argv[++i]);
+		} else if (arg == "--min-time") {
+			config.minSeconds = atof(argv[++i]);
+		} else if (arg == "--corpus") {
+			config.corpus = argv[++i];
+		} else if (arg == "--dump-dir") {
+			config.dumpDir = argv[++i];
+		} else {
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (config.scale <= 0.0) {
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	try {
+		if (config.corpus.empty() || config.corpus == "canada") {
+			BenchCorpus(config, "canada", MakeCanadaCorpus(config.scale));
+		}
+		if (config.corpus.empty() || config.corpus == "twitter") {
+			BenchCorpus(config, "twitter", MakeTwitterCorpus(config.scale));
+		}
+		if (config.corpus.empty() || config.corpus == "citm") {
+			BenchCorpus(config, "citm", MakeCitmCorpus(config.scale));
+		}
+	} catch (const std::exception &e) {
+		std::cerr << "Benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+	if (CU::JSONStatsEnabled()) {
+		std::cout << "{\"stats\":" << CU::GetGlobalStats().toObject().toString() << "}" << std::endl;
+	}
+
+	return 0;
+}
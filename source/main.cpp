@@ -1,5 +1,65 @@
-﻿#include <iostream>
+﻿#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
 #include "CuJSONObject.h"
+#include "CuJSONBatch.h"
+#include "CuJSONCanonical.h"
+#include "CuJSONCBOR.h"
+#include "CuJSONColumnar.h"
+#include "CuJSONLoader.h"
+#include "CuJSONParallel.h"
+#include "CuJSONParser.h"
+#include "CuJSONPatch.h"
+#include "CuJSONPointer.h"
+#include "CuJSONSchema.h"
+#include "CuJSONSnapshot.h"
+#include "CuJSONStatic.h"
+#include "CuJSONStats.h"
+#include "CuJSONWriter.h"
+
+namespace
+{
+    int failures = 0;
+
+    // Reports a broken expectation and keeps going, main() returns non-zero if any failed.
+    void Check(const bool &condition, const char* what)
+    {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    }
+
+    // Forwards to new/delete and keeps count of what went through it.
+    class CountingResource : public std::pmr::memory_resource
+    {
+        public:
+            size_t allocations = 0;
+            size_t live = 0;
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                allocations++;
+                live += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+            {
+                live -= bytes;
+                std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+            {
+                return this == &other;
+            }
+    };
+}
 
 int main()
 {
@@ -156,7 +216,523 @@ int main()
             std::cout << item.toRaw() << std::endl;
         }
         std::cout << array[8].toObject().toFormatedString() << std::endl;
+        Check(JSONArray(array.toString()).toString() == array.toString(), "pass1 round trip");
+    }
+
+    // JSONPointer / JSONPath test.
+    {
+        const std::string text("{\"a\": 1, \"b\": {\"x\": [10, 20]}, \"a\": {\"c\": 2}, \"b\": 3, \"d\": {\"e\": [1, {\"f\": true}]}}");
+        JSONObject object(text);
+        JSONItem extracted{};
+        Check(JSONPointer("/d/e/1/f").find(object)->toBoolean(), "pointer find");
+        Check(JSONPointer("/a/c").extract(text, extracted) && extracted.toInt() == 2, "pointer extract keeps the last duplicate");
+        Check(!JSONPointer("/b/x").extract(text, extracted) && JSONPointer("/b/x").find(object) == nullptr, "pointer extract skips replaced values");
+        const auto selected = JSONPath("$.*").select(object);
+        const auto scanned = JSONPath("$.*").extract(text);
+        bool same = (selected.size() == 3 && scanned.size() == 3);
+        for (size_t pos = 0; same && pos < selected.size(); pos++) {
+            same = (*selected[pos] == scanned[pos]);
+        }
+        Check(same, "path extract matches select with duplicated keys");
+        Check(JSONPath("$['d'].e[*]").extract(text).size() == 2, "path wildcard over an array");
+    }
+
+    // JSON Patch / Merge Patch test.
+    {
+        JSONObject source("{\"a\": 1, \"b\": [1, 2, 3], \"c\": {\"d\": \"x\", \"e\": null}, \"gone\": true}");
+        JSONObject target("{\"a\": 2, \"b\": [1, 3], \"c\": {\"d\": \"y\", \"e\": null, \"f\": [true]}, \"new\": {}}");
+        auto patched = source;
+        ApplyPatch(patched, CreatePatch(source, target));
+        Check(patched == target, "diff and apply JSON Patch");
+        JSONObject document("{\"title\": \"Goodbye!\", \"author\": {\"givenName\": \"John\", \"familyName\": \"Doe\"}, \"tags\": [\"example\", \"sample\"]}");
+        ApplyMergePatch(document, JSONObject("{\"title\": \"Hello!\", \"phoneNumber\": \"+01-123-456-7890\", \"author\": {\"familyName\": null}, \"tags\": [\"example\"]}"));
+        Check(document == JSONObject("{\"title\": \"Hello!\", \"author\": {\"givenName\": \"John\"}, \"tags\": [\"example\"], \"phoneNumber\": \"+01-123-456-7890\"}"), "RFC 7386 merge patch");
+        bool rejected = false;
+        try {
+            ApplyPatch(patched, JSONArray("[{\"op\": \"test\", \"path\": \"/a\", \"value\": 3}]"));
+        } catch (const JSONExcept &) {
+            rejected = true;
+        }
+        Check(rejected && patched == target, "failed test operation leaves the document unchanged");
+        JSONObject numbers("{\"one\": 1.0, \"five\": 5, \"list\": [2.5, 3]}");
+        numbers["five"] = int64_t(5);
+        rejected = false;
+        try {
+            ApplyPatch(numbers, JSONArray("[{\"op\": \"test\", \"path\": \"/one\", \"value\": 1}, {\"op\": \"test\", \"path\": \"/five\", \"value\": 5},"
+                "{\"op\": \"test\", \"path\": \"/list\", \"value\": [2.5, 3.0]}]"));
+        } catch (const JSONExcept &) {
+            rejected = true;
+        }
+        Check(!rejected, "test operation compares numbers by value");
+        JSONObject integers("{\"n\": [1]}"), doubles("{\"n\": [1.0]}");
+        ApplyPatch(integers, CreatePatch(integers, doubles));
+        Check(integers == doubles && integers["n"].asArray()[0].type() == ItemType::DOUBLE, "diff keeps number types apart");
+    }
+
+    // Cache invalidation through retained references test.
+    {
+        JSONObject root("{\"a\": {\"k0\": 0, \"k1\": [1, {\"x\": 2}]}, \"b\": [3, 4]}");
+        JSONObject twin(root);
+        auto &child = root["a"].asObject();
+        auto &inner = child["k1"].asArray()[1].asObject();
+        root.hash();
+        root.serializedSize();
+        twin.hash();
+        child["k0"] = 1;
+        inner["x"] = "changed";
+        twin["a"].asObject()["k0"] = 1;
+        twin["a"].asObject()["k1"].asArray()[1].asObject()["x"] = "changed";
+        Check(root.hash() == JSONObject(root.toString()).hash(), "hash after an edit through a child reference");
+        Check(root.serializedSize() == root.toString().size(), "size after an edit through a child reference");
+        Check(root == twin, "equality after the same edits");
+        root.cacheText(true);
+        root["padding"] = JSONArray();
+        for (int i = 0; i < 50; i++) {
+            root["padding"].asArray()[i] = "text long enough to be cached";
+        }
+        const auto before = root.toString();
+        child["k0"] = 2;
+        inner["x"] = "edited";
+        const auto after = root.toString();
+        Check(after != before && after == JSONObject(root).toString() && after.find("\"edited\"") != std::string::npos, "cached text after an edit through a child reference");
+        const auto hash = root.hash();
+        root.shrinkToFit();
+        root["padding"].asArray().shrinkToFit();
+        Check(root.hash() == hash && root.toString() == after, "relocating items keeps the caches");
+        inner["x"] = "again";
+        std::sort(root["padding"].asArray().begin(), root["padding"].asArray().end(), [](const JSONItem &, const JSONItem &) { return false; });
+        Check(root.toString() == JSONObject(root).toString() && root.hash() == JSONObject(root.toString()).hash(), "edit after relocating items");
+    }
+
+    // Canonical (JCS) serialization test.
+    {
+        JSONObject object("{\"numbers\": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001], \"string\": \"\\u20ac$\\u000F\\u000aA'\\u0042\\u0022\\u005c\\\\\\\"\\/\", \"literals\": [null, true, false]}");
+        Check(ToCanonicalString(object) == "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],\"string\":\"\xE2\x82\xAC$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}", "RFC 8785 example");
+        Check(ToCanonicalString(JSONObject("{\"\\ufb01\": 1, \"b\": 2, \"\\ud83d\\ude00\": 3, \"a\": 4}")) == "{\"a\":4,\"b\":2,\"\xF0\x9F\x98\x80\":3,\"\xEF\xAC\x81\":1}", "keys sorted by UTF-16 code units");
+        Check(ToCanonicalString(JSONObject("{\"b\": [1, 2], \"a\": {\"y\": 1, \"x\": 2}}")) == ToCanonicalString(JSONObject("{\"a\": {\"x\": 2, \"y\": 1}, \"b\": [1, 2]}")), "equal documents give the same text");
+    }
+
+    // CBOR test.
+    {
+        JSONObject object("{\"int\": 1, \"long\": 5000000000, \"double\": 0.5, \"list\": [1, 2, 3], \"text\": \"abc\", \"nested\": {\"null\": null, \"flag\": true}}");
+        JSONObject decoded{};
+        ReadCBOR(ToCBOR(object), decoded);
+        Check(decoded == object, "CBOR round trip");
+        JSONItem tagged{};
+        ReadCBOR(std::string("\xC6\xC6\x01", 3), tagged);
+        Check(tagged.type() == ItemType::INTEGER && tagged.toInt() == 1, "CBOR value behind unknown tags is kept");
+        bool rejected = false;
+        try {
+            ReadCBOR(std::string(1000000, '\xC6'), tagged);
+        } catch (const JSONExcept &) {
+            rejected = true;
+        }
+        Check(rejected, "CBOR stream of tags is rejected without recursion");
+    }
+
+    // Snapshot test.
+    {
+        JSONObject object("{\"name\": \"snapshot\", \"list\": [1, 5000000000, 0.5, true, null], \"nested\": {\"b\": [], \"a\": {}}}");
+        const auto bytes = ToSnapshot(object);
+        const JSONSnapshot snapshot(bytes);
+        Check(snapshot.root().toItem().toObject() == object, "snapshot round trip");
+        Check(snapshot.root().at("list").at(1).toLong() == 5000000000, "snapshot lookup");
+        // [[1]] with the inner array pointing back at the outer one, then with a huge count.
+        auto damaged = ToSnapshot(JSONArray("[[1]]"));
+        uint64_t outer = 0;
+        std::memcpy(&outer, damaged.data() + 32, sizeof(outer));
+        std::memcpy(&damaged[static_cast<size_t>(outer) + 8], &outer, sizeof(outer));
+        bool rejected = false;
+        try {
+            JSONSnapshot(damaged).root().toItem();
+        } catch (const JSONExcept &) {
+            rejected = true;
+        }
+        Check(rejected, "self-referencing snapshot is rejected");
+        const uint32_t count = UINT32_MAX;
+        std::memcpy(&damaged[28], &count, sizeof(count));
+        rejected = false;
+        try {
+            JSONSnapshot(damaged).root().toItem();
+        } catch (const JSONExcept &) {
+            rejected = true;
+        }
+        Check(rejected, "snapshot count beyond the data is rejected");
+    }
+
+    // JSONSchema test.
+    {
+        const JSONSchema schema(JSONObject("{\"type\": \"object\", \"required\": [\"id\", \"tags\"], \"properties\": {"
+            "\"id\": {\"type\": \"integer\", \"exclusiveMinimum\": 0, \"minimum\": 1, \"exclusiveMaximum\": 100, \"maximum\": 200},"
+            "\"score\": {\"type\": \"number\", \"exclusiveMinimum\": 0, \"maximum\": 10},"
+            "\"tags\": {\"type\": \"array\", \"maxItems\": 2, \"items\": {\"ignore\": true}}}}"));
+        JSONParser parser{};
+        const auto valid = [&parser, &schema](const std::string &text) {
+            JSONObject object{};
+            try {
+                parser.parse(text, object, schema);
+            } catch (const JSONExcept &) {
+                return false;
+            }
+            return true;
+        };
+        Check(valid("{\"id\": 1, \"score\": 10, \"tags\": [\"a\", \"b\"]}"), "schema accepts the inclusive bounds");
+        Check(!valid("{\"id\": 100, \"tags\": []}"), "schema exclusiveMaximum next to a maximum");
+        Check(!valid("{\"id\": 5, \"score\": 0, \"tags\": []}"), "schema exclusiveMinimum");
+        Check(!valid("{\"id\": 0, \"tags\": []}") && !valid("{\"id\": 5, \"score\": 10.5, \"tags\": []}"), "schema inclusive bounds");
+        Check(!valid("{\"id\": 5, \"tags\": [\"a\", \"b\", \"c\"]}"), "schema maxItems counts skipped items");
+        Check(!valid("{\"id\": 5}"), "schema required key");
+    }
+
+    // Parallel serialization test, also run by the CUJSON_ENABLE_STATS build.
+    {
+        JSONArray array{};
+        for (int i = 0; i < 5000; i++) {
+            array.add(JSONObject("{\"id\": " + std::to_string(i) + ", \"name\": \"item\", \"tags\": [1, 2.5, null]}"));
+        }
+        JSONStats stats{};
+        std::string text{};
+        {
+            JSONStatsScope scope(stats);
+            WriteParallel(array, text, 4);
+        }
+        Check(text == array.toString(), "parallel serialization matches toString()");
+        Check(!JSONStatsEnabled() || stats.bytesSerialized == text.size(), "parallel serialization reports its output");
+    }
+
+    // Incremental parsing and LoadAsync test.
+    {
+        const std::string text("{\"key\": \"v\\u00e9\\\"lue\", \"numbers\": [1, -2.5e3, 5000000000], \"nested\": {\"a\": [true, false, null], \"b\": {}}, \"empty\": []}");
+        const JSONObject expected(text);
+        JSONParser parser{};
+        bool same = true;
+        for (const size_t &step : {size_t(1), size_t(2), size_t(7)}) {
+            JSONItem item{};
+            parser.begin(item);
+            for (size_t pos = 0; pos < text.size(); pos += step) {
+                parser.feed(std::string_view(text).substr(pos, step));
+            }
+            parser.finish();
+            same = same && item.type() == ItemType::OBJECT && item.asObject() == expected;
+        }
+        Check(same, "feed() on input split anywhere");
+        const char* path = "cujson_load_test.json";
+        std::ofstream(path, std::ios::binary) << text;
+        JSONLoadOptions options{};
+        options.blockSize = 16;
+        options.blockCount = 2;
+        const auto loaded = LoadAsync(path, options).get();
+        std::remove(path);
+        Check(loaded.type() == ItemType::OBJECT && loaded.asObject() == expected, "LoadAsync in small blocks");
+    }
+
+    // ParseStatic test.
+    {
+        static constexpr auto document = ParseStatic("{\"a\": [1, [2, 3], {\"b\": null}], \"c\": \"text\", \"a\": 5000000000}");
+        static_assert(document.root().at("c").toString() == "text", "static lookup at compile time");
+        Check(document.root().toItem().toObject() == JSONObject("{\"a\": 5000000000, \"c\": \"text\"}"), "static document converts to a tree");
+        Check(document.root().at(0).toItem().toArray() == JSONArray("[1, [2, 3], {\"b\": null}]"), "static array converts to a tree");
+        static constexpr auto numbers = ParseStatic<8>("[-2147483648, -9223372036854775808, 0.25, -1.5e3, true, \"\\u00e9\"]");
+        static_assert(numbers.nodeCount() == 7 && sizeof(numbers) < 8 * 24 + 96, "explicit node count");
+        static_assert(numbers.root().at(0).toInt() == INT_MIN && numbers.root().at(1).toLong() == INT64_MIN, "static integers");
+        static_assert(numbers.root().at(2).toDouble() == 0.25 && numbers.root().at(3).toDouble() == -1500.0, "static doubles");
+        static_assert(numbers.root().at(4).toBoolean() && numbers.root().at(5).toString() == "\xc3\xa9", "static literals");
+        Check(numbers.root().toItem().toArray() == JSONArray("[-2147483648, -9223372036854775808, 0.25, -1.5e3, true, \"\\u00e9\"]"), "static numbers convert to a tree");
+        Check(ParseStatic("[1e400, 0.1]").root().at(1).toDouble() == 0.1 && ParseStatic("[123456789012345678901]").root().at(0).toDouble() == 123456789012345678901.0, "static doubles beyond the fast path");
+        bool overflowed = false;
+        try {
+            ParseStatic<2>("[1, 2]");
+        } catch (const JSONExcept &) {
+            overflowed = true;
+        }
+        Check(overflowed && sizeof(_StaticNode) == 20, "explicit node count too small");
+    }
+
+    // JSONMemoryScope test.
+    {
+        CountingResource scoped{};
+        CountingResource fallback{};
+        const auto previous = std::pmr::set_default_resource(&fallback);
+        {
+            JSONObject outside("{\"kept\": [\"a string too long for the inline buffer\", 2, {\"x\": 3}]}");
+            const size_t outsideAllocations = fallback.allocations;
+            JSONItem item{};
+            {
+                JSONMemoryScope scope(&scoped);
+                JSONParser().parse("{\"key with a long enough name\": [1, 2.5, \"value long enough to allocate\"], \"nested\": {\"a\": [[], {}]}}", item);
+                Check(scoped.allocations > 0 && fallback.allocations == outsideAllocations, "parsing allocates from the scope's resource only");
+                Check(item.memoryUsage().total() == scoped.live, "memoryUsage() matches the scope's resource");
+                item.asObject()["copied"] = outside;
+            }
+            item.asObject()["moved"] = std::move(outside["kept"]);
+            outside["added"] = item.asObject()["nested"];
+            Check(scoped.live > 0 && item.asObject()["moved"].asArray()[2].asObject()["x"].toInt() == 3 && outside["added"].asObject().contains("a"), "values from different resources mixed");
+        }
+        std::pmr::set_default_resource(previous);
+        Check(scoped.live == 0 && fallback.live == 0, "mixed values released to their own resources");
+    }
+
+    // JSONDocument reuse test.
+    {
+        JSONParser parser{};
+        JSONDocument document{};
+        parser.parse("{\"a\": [1, 2, 3], \"b\": {\"c\": \"first\"}}", document);
+        parser.parse("{\"b\": {\"d\": true}, \"e\": null}", document);
+        Check(document.object() == JSONObject("{\"b\": {\"d\": true}, \"e\": null}") && document.object().toString() == "{\"b\":{\"d\":true},\"e\":null}", "second parse into a document leaves no stale members");
+        parser.parse("[\"x\"]", document);
+        Check(document.root().type() == ItemType::ARRAY && document.array() == JSONArray("[\"x\"]"), "second parse into a document of another root type");
+    }
+
+    // Parser limits test.
+    {
+        const auto rejected = [](const std::function<void()> &parse) {
+            try {
+                parse();
+            } catch (const JSONExcept &) {
+                return true;
+            }
+            return false;
+        };
+        const std::string deep = std::string(100000, '[') + std::string(100000, ']');
+        const std::string atLimit = std::string(1024, '[') + std::string(1024, ']');
+        Check(rejected([&deep]() { JSONArray array(deep); }), "deep nesting throws from the string constructor");
+        Check(rejected([&deep]() { JSONItem item{}; JSONParser().parse(deep, item); }), "deep nesting throws from JSONParser");
+        Check(!rejected([&atLimit]() { JSONArray array(atLimit); }), "nesting at maxDepth is accepted");
+        JSONParser::Options options{};
+        options.maxDocumentSize = 16;
+        JSONParser limited(options);
+        Check(!rejected([&limited]() { JSONItem item{}; limited.parse("[1, 2, 3, 4, 5]", item); }), "document within maxDocumentSize");
+        Check(rejected([&limited]() { JSONItem item{}; limited.parse("[1, 2, 3, 4, 5, 6]", item); }), "document over maxDocumentSize");
+        Check(rejected([&limited]() {
+            JSONItem item{};
+            limited.begin(item);
+            limited.feed("[1, 2, 3, ");
+            limited.feed("4, 5, 6]");
+            limited.finish();
+        }), "fed document over maxDocumentSize");
+    }
+
+    // JSONProjection test.
+    {
+        const JSONProjection projection({"user.name", "user.address", "items.id", "flag.value", "meta"});
+        const std::string text("{\"user\": {\"name\": \"a\", \"age\": 3, \"tags\": [\"x\", {\"y\": \"\\u0041\"}], \"address\": {\"city\": \"x\", \"zip\": 1}},"
+            "\"items\": [{\"id\": 1, \"x\": [2]}, 5, {\"id\": 3}], \"other\": {\"id\": 4}, \"flag\": 7, \"meta\": {\"k\": [1]}}");
+        JSONParser parser{};
+        JSONObject object{};
+        parser.parse(text, object, projection);
+        Check(object.toString() == "{\"user\":{\"name\":\"a\",\"address\":{\"city\":\"x\",\"zip\":1}},\"items\":[{\"id\":1},{\"id\":3}],\"meta\":{\"k\":[1]}}",
+            "projection keeps nested paths and skips the rest");
+        JSONItem item{};
+        parser.parse("[{\"id\": 1, \"x\": 2}, \"text\", {\"y\": 3}]", item, JSONProjection({"id"}));
+        Check(item.type() == ItemType::ARRAY && item.asArray() == JSONArray("[{\"id\": 1}, {}]"), "projection over a root array");
+    }
+
+    // Columnar conversion test.
+    {
+        const std::string text("{\"id\": 1, \"name\": \"b\", \"v\": 1, \"m\": 1, \"flag\": true}\n"
+            "\n"
+            "{\"id\": 2, \"name\": \"a\", \"v\": 2.5, \"m\": \"x\", \"extra\": null}\r\n"
+            "  \n"
+            "{\"id\": 5000000000, \"name\": \"b\", \"v\": null, \"m\": [1]}");
+        const auto columns = ReadColumns(text);
+        const auto column = [&columns](const char* name) { return columns.find(name); };
+        Check(columns.rows == 3 && columns.columns.size() == 6 && columns.columns[4].name == "flag" && columns.columns[5].name == "extra", "columns in first seen order, blank lines skipped");
+        Check(column("id")->type == ColumnType::LONG && column("id")->longs == std::vector<int64_t>({1, 2, 5000000000}), "integers and longs share a LONG column");
+        Check(column("name")->type == ColumnType::STRING && column("name")->dictionary == std::vector<std::string>({"b", "a"}) &&
+            column("name")->codes == std::vector<uint32_t>({0, 1, 0}), "dictionary codes in first seen order");
+        Check(column("v")->type == ColumnType::DOUBLE && column("v")->doubles[0] == 1.0 && column("v")->doubles[1] == 2.5 &&
+            column("v")->nullCount == 1 && column("v")->valid(1) && !column("v")->valid(2), "LONG column widened to DOUBLE with a null bit");
+        const auto mixed = column("m");
+        Check(mixed->type == ColumnType::MIXED && mixed->items[0].toLong() == 1 && mixed->items[1].toString() == "x" &&
+            mixed->items[2].type() == ItemType::ARRAY && mixed->longs.empty() && mixed->dictionary.empty(), "mixed field keeps the earlier rows");
+        Check(column("flag")->missingCount == 2 && column("flag")->valid(0) && !column("flag")->valid(1) && column("flag")->booleans[0] == 1, "missingCount of a field in the first record only");
+        Check(column("extra")->type == ColumnType::COLUMN_NULL && column("extra")->nullCount == 1 && column("extra")->missingCount == 2 &&
+            !column("extra")->valid(1), "null-only field");
+        JSONArray records{};
+        for (const auto &line : {"{\"id\": 1, \"name\": \"b\", \"v\": 1, \"m\": 1, \"flag\": true}", "{\"id\": 2, \"name\": \"a\", \"v\": 2.5, \"m\": \"x\", \"extra\": null}",
+            "{\"id\": 5000000000, \"name\": \"b\", \"v\": null, \"m\": [1]}"}) {
+            records.add(JSONObject(line));
+        }
+        const auto converted = ToColumns(records);
+        bool same = (converted.rows == columns.rows && converted.columns.size() == columns.columns.size());
+        for (size_t pos = 0; same && pos < columns.columns.size(); pos++) {
+            const auto &left = converted.columns[pos];
+            const auto &right = columns.columns[pos];
+            same = (left.name == right.name && left.type == right.type && left.validity == right.validity && left.longs == right.longs &&
+                left.doubles == right.doubles && left.codes == right.codes && left.items == right.items);
+        }
+        Check(same, "ToColumns matches ReadColumns");
+        std::string error{};
+        try {
+            ReadColumns("{\"a\": 1}\n\n{\"a\": }\n");
+        } catch (const JSONExcept &e) {
+            error = e.what();
+        }
+        Check(error.rfind("Line 3: ", 0) == 0, "NDJSON error names the line");
+    }
+
+    // JSONBatch test.
+    {
+        std::vector<std::string> texts{};
+        for (int i = 0; i < 300; i++) {
+            texts.emplace_back((i % 50 == 7) ? "{\"id\": " + std::to_string(i) + ",}" : "{\"id\": " + std::to_string(i) + ", \"tags\": [\"t\"]}");
+        }
+        JSONBatchOptions options{};
+        options.threads = 4;
+        options.minThreadDocuments = 1;
+        JSONBatch batch{};
+        bool same = true;
+        for (int round = 0; round < 2; round++) {
+            std::vector<std::string_view> views(texts.begin(), texts.end() - round * 100);
+            batch.parse(views, options);
+            same = same && batch.size() == views.size() && batch.failures() == views.size() / 50;
+            for (size_t pos = 0; same && pos < batch.size(); pos++) {
+                const auto &document = static_cast<const JSONBatch &>(batch)[pos];
+                same = (pos % 50 == 7) ? (!batch.ok(pos) && batch.error(pos).find("Invalid JSON") != std::string::npos && document.empty()) :
+                    (batch.ok(pos) && document == JSONObject(texts[pos]));
+            }
+        }
+        Check(same, "batch keeps per-document errors across two batches");
+        batch[0]["added"] = "outside the arena";
+        batch.parse(std::vector<std::string_view>{"{\"a\": 1}", "[]"});
+        Check(batch.failures() == 1 && batch.ok(0) && batch[0].at("a").toInt() == 1 && !batch.ok(1), "batch reused after an edit");
+    }
+
+    // Lazy numbers test.
+    {
+        JSONParser::Options options{};
+        options.lazyNumbers = true;
+        JSONParser lazy(options);
+        JSONParser eager{};
+        const auto parse = [](JSONParser &parser, const std::string &text) {
+            JSONItem item{};
+            parser.parse(text, item);
+            return item;
+        };
+        Check(parse(lazy, "[1.5,1e2,-0]").toRaw() == "[1.5,1e2,-0]" && parse(eager, "[1.5,1e2,-0]").toRaw() == "[1.500000,100.000000,0]", "lazy numbers are written back verbatim");
+        const std::string limits("[2147483647, -2147483648, 2147483648, -2147483649, 9223372036854775807, -9223372036854775808, 9223372036854775808, 1.7976931348623157e308, 5e-324, 0.1, -0]");
+        const auto lazyLimits = parse(lazy, limits);
+        const auto eagerLimits = parse(eager, limits);
+        Check(lazyLimits == eagerLimits && lazyLimits.hash() == eagerLimits.hash(), "lazy and eager trees are equal with equal hashes");
+        bool same = true;
+        for (size_t pos = 0; pos < eagerLimits.asArray().size(); pos++) {
+            const auto &left = *lazyLimits.asArray().lookup(pos);
+            const auto &right = *eagerLimits.asArray().lookup(pos);
+            same = same && left.type() == right.type() && left.toInt() == right.toInt() && left.toLong() == right.toLong() && left.toDouble() == right.toDouble() && left.value() == right.value();
+        }
+        Check(same, "lazy numbers convert like eager ones at the limits");
+        static_assert(std::variant_size_v<ItemValue> == 8, "value() keeps the stored representation private");
+        const std::string fallback("[01, 1., -01, 0.1000000000000000000000000000000000000000001, 123456789012345678901234567890123456789012345]");
+        const auto lazyFallback = parse(lazy, fallback);
+        Check(lazyFallback.toRaw() == parse(eager, fallback).toRaw() && lazyFallback == parse(eager, fallback), "long and non-strict tokens fall back to eager conversion");
+    }
+
+    // In-situ strings test.
+    {
+        JSONParser::Options options{};
+        options.inSitu = true;
+        JSONParser parser(options);
+        std::string buffer("{\"plain\": \"abc\", \"escaped\": \"a\\nb\", \"list\": [\"def\"]}");
+        const auto inBuffer = [&buffer](const std::string_view &str) {
+            return (str.data() >= buffer.data() && str.data() < buffer.data() + buffer.size());
+        };
+        JSONItem item{};
+        parser.parse(buffer, item);
+        const auto &object = item.asObject();
+        Check(inBuffer(object.lookup("plain")->asString()) && inBuffer(object.lookup("list")->asArray().lookup(0)->asString()), "unescaped strings are views into the text");
+        Check(!inBuffer(object.lookup("escaped")->asString()) && object.lookup("escaped")->asString() == "a\nb", "escaped strings are owned");
+        const JSONItem copy(item);
+        const std::string expected = item.toRaw();
+        std::fill(buffer.begin(), buffer.end(), 'x');
+        Check(copy.toRaw() == expected && !inBuffer(copy.asObject().lookup("plain")->asString()), "a copy survives overwriting the text");
+        buffer = "{\"fed\": \"value\", \"more\": [\"text\"]}";
+        JSONItem fed{};
+        parser.begin(fed);
+        parser.feed(std::string_view(buffer).substr(0, 20));
+        parser.feed(std::string_view(buffer).substr(20));
+        parser.finish();
+        JSONItem other{};
+        parser.begin(other);
+        parser.feed("{\"overwrite\": \"the pending text\", \"of\": \"the parser\"}");
+        parser.finish();
+        Check(!inBuffer(fed.asObject().lookup("fed")->asString()) && fed.asObject().toString() == "{\"fed\":\"value\",\"more\":[\"text\"]}", "feed() copies its strings");
+    }
+
+    // shrinkToFit test.
+    {
+        CountingResource counting{};
+        JSONMemoryScope scope(&counting);
+        JSONObject object{};
+        for (int i = 0; i < 100; i++) {
+            object.add("key" + std::to_string(i), JSONArray("[1, 2, 3, 4, 5, 6, 7, 8]"));
+        }
+        for (int i = 0; i < 100; i++) {
+            if (i < 10) {
+                object["key" + std::to_string(i)].asArray().remove(8);
+            } else {
+                object.remove("key" + std::to_string(i));
+            }
+        }
+        const JSONObject copy(object);
+        const auto before = object.memoryUsage();
+        object.shrinkToFit();
+        const auto after = object.memoryUsage();
+        Check(before.slack > after.slack && after.total() < before.total() && object == copy && object.toString() == copy.toString(), "shrinkToFit() drops slack and keeps the content");
+        Check(after.total() + copy.memoryUsage().total() == counting.live, "memoryUsage() matches the allocations");
+    }
+
+    // Mutable iteration test.
+    {
+        JSONObject object("{\"z\": 1, \"a\": {\"n\": 2}, \"m\": [3]}");
+        const auto hash = object.hash();
+        const auto text = object.toString();
+        std::string keys{};
+        for (auto &[key, value] : object) {
+            keys += key;
+            if (key == "a") {
+                value.asObject()["n"] = 20;
+            } else if (key == "m") {
+                value = "three";
+            }
+        }
+        Check(keys == "zam" && object.toString() == "{\"z\":1,\"a\":{\"n\":20},\"m\":\"three\"}", "structured bindings keep insertion order and write through");
+        Check(object.hash() != hash && object.toString() != text && object.hash() == JSONObject(object.toString()).hash(), "writes through iteration drop the caches");
+    }
+
+    // JSONWriter test.
+    {
+        const JSONObject tree("{\"name\": \"a \\\"quoted\\\" \\u00e9\", \"values\": [1, -5000000000, 0.5, true, null, {}], \"nested\": {\"list\": [[], [\"x\"]]}}");
+        std::string text{};
+        JSONWriter writer(text);
+        writer.startObject().key("name").value(tree.at("name").toString());
+        writer.key("values").startArray().value(1).value(static_cast<int64_t>(-5000000000)).value(0.5).value(true).value(nullptr).startObject().endObject().endArray();
+        writer.key("nested").value(tree.at("nested")).endObject();
+        Check(writer.complete() && text == JSONItem(tree).toRaw(), "writer output matches toRaw()");
+        text.clear();
+        JSONWriter(text).startArray().value(static_cast<uint8_t>(255)).value(UINT64_MAX).value(static_cast<short>(-3)).endArray();
+        Check(text == "[255,18446744073709551615,-3]", "writer takes any integer type");
+        std::string sunk{};
+        {
+            JSONWriter sinkWriter([&sunk](const std::string_view &chunk) { sunk += chunk; });
+            sinkWriter.startArray().value("pending").endArray();
+        }
+        Check(sunk == "[\"pending\"]", "writer flushes its sink on destruction");
+#ifndef NDEBUG
+        const auto misplaced = [](const std::function<void(JSONWriter &)> &write) {
+            std::string buffer{};
+            JSONWriter checked(buffer);
+            try {
+                write(checked);
+            } catch (const JSONExcept &) {
+                return true;
+            }
+            return false;
+        };
+        Check(misplaced([](JSONWriter &checked) { checked.startArray().key("k"); }), "writer rejects a key in an array");
+        Check(misplaced([](JSONWriter &checked) { checked.startObject().endArray(); }), "writer rejects a mismatched end");
+        Check(misplaced([](JSONWriter &checked) { checked.startObject().value(1); }), "writer rejects a value without a key");
+#endif
     }
 
-    return 0;
+    return (failures == 0) ? 0 : 1;
 }